@@ -0,0 +1,167 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "fastcsum.h"
+
+// One checksum call: `size` bytes starting `offset` bytes into a cache line-aligned buffer.
+struct bench_packet {
+    uint32_t size;
+    uint32_t offset;
+};
+
+/*
+ * Random data laid out with each packet in its own cache line-aligned slot, so starting offsets are preserved as on a
+ * NIC receive ring. Sized by the packets it holds: a working set much larger than the last-level cache keeps the
+ * benchmark from running out of a few hot lines the way a single reused buffer does.
+ */
+class bench_pool {
+public:
+    static constexpr size_t line = 64;
+
+    explicit bench_pool(const std::vector<bench_packet> &packets) {
+        size_t total = 0;
+        for (auto &p : packets)
+            total += slot(p);
+        arena.resize((total + line) / sizeof(uint64_t) + 1);
+        std::mt19937_64 rnd(2);
+        for (auto &w : arena)
+            w = rnd();
+
+        auto base = reinterpret_cast<uint8_t *>(arena.data());
+        auto pos = base + (line - reinterpret_cast<uintptr_t>(base) % line) % line;
+        for (auto &p : packets) {
+            ptrs.push_back(pos + p.offset);
+            pos += slot(p);
+        }
+    }
+
+    const uint8_t *operator[](size_t i) const {
+        return ptrs[i];
+    }
+
+    size_t bytes() const {
+        return arena.size() * sizeof(uint64_t);
+    }
+
+private:
+    static size_t slot(const bench_packet &p) {
+        return (p.offset + p.size + line - 1) / line * line;
+    }
+
+    std::vector<uint64_t> arena;
+    std::vector<const uint8_t *> ptrs;
+};
+
+// Time-stamp counter ticks (reference cycles at the nominal frequency), or 0 where there is no such counter.
+static inline uint64_t bench_ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Wall time and ticks of one timed region, from construction to `stop`.
+class bench_timer {
+public:
+    void stop() {
+        end_ticks = bench_ticks();
+        end = std::chrono::steady_clock::now();
+    }
+
+    double seconds() const {
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    uint64_t ticks() const {
+        return end_ticks - start_ticks;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t start_ticks = bench_ticks();
+    std::chrono::steady_clock::time_point end = start;
+    uint64_t end_ticks = start_ticks;
+};
+
+// Measures the tick rate against the steady clock, or returns 0 where there is no tick counter.
+static inline double bench_tick_hz() {
+    if (!bench_ticks())
+        return 0;
+    bench_timer t;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    t.stop();
+    return t.ticks() / t.seconds();
+}
+
+static inline bool bench_always_usable(void) {
+    return true;
+}
+
+// The dispatched entry point, timed next to the kernels it picks from.
+static const fastcsum_kernel bench_dispatched = {"nofold", fastcsum_nofold, bench_always_usable};
+
+// The kernels fastcsum_kernels() leaves out as deprecated, still timed against the ones that replaced them.
+static inline const fastcsum_kernel *bench_deprecated_kernels(size_t *n) {
+#if defined(__x86_64__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    static const fastcsum_kernel kernels[] = {
+        {"adx", fastcsum_nofold_adx, fastcsum_adx_usable},
+        {"adx_align", fastcsum_nofold_adx_align, fastcsum_adx_usable},
+        {"adx_align2", fastcsum_nofold_adx_align2, fastcsum_adx_usable},
+        {"avx2", fastcsum_nofold_avx2, fastcsum_avx2_usable},
+        {"avx2_align", fastcsum_nofold_avx2_align, fastcsum_avx2_usable},
+        {"avx2_v2", fastcsum_nofold_avx2_v2, fastcsum_avx2_usable},
+        {"avx2_256b", fastcsum_nofold_avx2_256b, fastcsum_avx2_usable},
+        {"avx2_v3", fastcsum_nofold_avx2_v3, fastcsum_avx2_usable},
+        {"avx2_v4", fastcsum_nofold_avx2_v4, fastcsum_avx2_usable},
+        {"avx2_v5", fastcsum_nofold_avx2_v5, fastcsum_avx2_usable},
+        {"avx2_v6", fastcsum_nofold_avx2_v6, fastcsum_avx2_usable},
+    };
+#pragma GCC diagnostic pop
+    *n = sizeof(kernels) / sizeof(kernels[0]);
+    return kernels;
+#else
+    *n = 0;
+    return nullptr;
+#endif
+}
+
+// Looks `name` up among the registry, the deprecated kernels and the dispatched entry point.
+static inline const fastcsum_kernel *bench_kernel_find(const char *name) {
+    if (auto k = fastcsum_kernel_find(name))
+        return k;
+    size_t n;
+    auto deprecated = bench_deprecated_kernels(&n);
+    for (size_t i = 0; i < n; i++)
+        if (strcmp(deprecated[i].name, name) == 0)
+            return &deprecated[i];
+    return strcmp(name, bench_dispatched.name) == 0 ? &bench_dispatched : nullptr;
+}
+
+// Every kernel in fastcsum.h that can run here, deprecated ones included, followed by the dispatched entry point.
+static inline std::vector<const fastcsum_kernel *> bench_usable_kernels() {
+    std::vector<const fastcsum_kernel *> out;
+    size_t n;
+    auto all = fastcsum_kernels(&n);
+    for (size_t i = 0; i < n; i++)
+        if (all[i].usable())
+            out.push_back(&all[i]);
+    auto deprecated = bench_deprecated_kernels(&n);
+    for (size_t i = 0; i < n; i++)
+        if (deprecated[i].usable())
+            out.push_back(&deprecated[i]);
+    out.push_back(&bench_dispatched);
+    return out;
+}
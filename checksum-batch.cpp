@@ -0,0 +1,66 @@
+#include "fastcsum.h"
+
+static constexpr size_t batch_chunk = 64;
+
+extern "C" void fastcsum_nofold_batch_generic(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t out[]) {
+    auto fn = fastcsum_nofold_best();
+    for (size_t i = 0; i < n; i++)
+        out[i] = fn(ptrs[i], sizes[i], initials ? initials[i] : 0);
+}
+
+extern "C" void fastcsum_nofold_batch(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t out[]) {
+#if defined(__x86_64__)
+    // adx_v2 has little enough setup that it beats gathers wherever it is available
+    if (!fastcsum_adx_usable() && fastcsum_avx2_usable()) {
+        fastcsum_nofold_batch_avx2(ptrs, sizes, n, initials, out);
+        return;
+    }
+#endif
+    fastcsum_nofold_batch_generic(ptrs, sizes, n, initials, out);
+}
+
+extern "C" void fastcsum_batch_fold_complement(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint16_t out[]) {
+    uint64_t sums[batch_chunk];
+    for (size_t i = 0; i < n; i += batch_chunk) {
+        auto todo = n - i < batch_chunk ? n - i : batch_chunk;
+        fastcsum_nofold_batch(&ptrs[i], &sizes[i], todo, initials ? &initials[i] : nullptr, sums);
+        for (size_t j = 0; j < todo; j++)
+            out[i + j] = fastcsum_fold_complement(sums[j]);
+    }
+}
+
+extern "C" size_t fastcsum_batch_verify(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t mismatch[]) {
+    static_assert(batch_chunk == 64, "one mismatch word per chunk");
+    uint64_t sums[batch_chunk];
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i += batch_chunk) {
+        auto todo = n - i < batch_chunk ? n - i : batch_chunk;
+        fastcsum_nofold_batch(&ptrs[i], &sizes[i], todo, initials ? &initials[i] : nullptr, sums);
+        uint64_t word = 0;
+        for (size_t j = 0; j < todo; j++)
+            word |= static_cast<uint64_t>(fastcsum_fold_complement(sums[j]) != 0) << j;
+        mismatch[i / batch_chunk] = word;
+        bad += __builtin_popcountll(word);
+    }
+    return bad;
+}
@@ -0,0 +1,62 @@
+#include "fastcsum.h"
+#include "threadpool.hpp"
+
+// Below this many bytes per thread, waking up workers costs more than it saves.
+static constexpr size_t min_parallel_chunk = 256 * 1024;
+
+// Below this block size, a single streaming pass beats one call per block; from it on, avx2_v7 calls win.
+static constexpr size_t min_avx2_v7_block = 128;
+
+static void blocks_range(const uint8_t *ptr, size_t size, size_t block_size, uint16_t out[]) {
+    auto fn = fastcsum_nofold_best();
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable()) {
+        if (block_size < min_avx2_v7_block) {
+            fastcsum_blocks_avx2(ptr, size, block_size, out);
+            return;
+        }
+        fn = fastcsum_nofold_avx2_v7;
+    }
+#endif
+    size_t n = 0;
+    size_t off = 0;
+    for (; size - off >= block_size; off += block_size)
+        out[n++] = fastcsum_fold_complement(fn(ptr + off, block_size, 0));
+    if (off < size)
+        out[n] = fastcsum_fold_complement(fn(ptr + off, size - off, 0));
+}
+
+extern "C" size_t fastcsum_blocks(const uint8_t *ptr, size_t size, size_t block_size, uint16_t out[]) {
+    if (!block_size)
+        return 0;
+    blocks_range(ptr, size, block_size, out);
+    return (size + block_size - 1) / block_size;
+}
+
+extern "C" size_t fastcsum_blocks_parallel(
+    const uint8_t *ptr,
+    size_t size,
+    size_t block_size,
+    uint16_t out[],
+    unsigned int nthreads) {
+    if (!block_size)
+        return 0;
+    auto nblocks = (size + block_size - 1) / block_size;
+    nthreads = shared_pool_threads(nthreads);
+    if (size / min_parallel_chunk < nthreads)
+        nthreads = static_cast<unsigned int>(size / min_parallel_chunk);
+    if (nblocks < nthreads)
+        nthreads = static_cast<unsigned int>(nblocks);
+    if (nthreads <= 1)
+        return fastcsum_blocks(ptr, size, block_size, out);
+
+    // whole blocks per thread, so every result is computed by exactly one thread and needs no merging
+    shared_pool_run(nthreads, [&](unsigned int i) {
+        auto first = nblocks * i / nthreads;
+        auto last = nblocks * (i + 1) / nthreads;
+        auto start = first * block_size;
+        auto end = last * block_size < size ? last * block_size : size;
+        blocks_range(ptr + start, end - start, block_size, out + first);
+    });
+    return nblocks;
+}
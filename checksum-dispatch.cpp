@@ -0,0 +1,67 @@
+#include <cstring>
+
+#include "fastcsum.h"
+
+static fastcsum_nofold_fn resolve_best() {
+#if defined(__x86_64__)
+    if (fastcsum_adx_usable())
+        return fastcsum_nofold_adx_v2;
+    return fastcsum_nofold_x64_64b;
+#else
+    return fastcsum_nofold_generic64;
+#endif
+}
+
+extern "C" fastcsum_nofold_fn fastcsum_nofold_best() {
+    static const fastcsum_nofold_fn best = resolve_best();
+    return best;
+}
+
+extern "C" uint64_t fastcsum_nofold(const uint8_t *ptr, size_t size, uint64_t initial) {
+    return fastcsum_nofold_best()(ptr, size, initial);
+}
+
+static bool always_usable() {
+    return true;
+}
+
+#if defined(__x86_64__)
+static bool adx_usable() {
+    return fastcsum_adx_usable();
+}
+
+static bool avx2_usable() {
+    return fastcsum_avx2_usable();
+}
+#endif
+
+static const fastcsum_kernel kernels[] = {
+    {"generic64", fastcsum_nofold_generic64, always_usable},
+    {"generic64_align", fastcsum_nofold_generic64_align, always_usable},
+    {"simple", fastcsum_nofold_simple, always_usable},
+    {"simple2", fastcsum_nofold_simple2, always_usable},
+    {"simple_align", fastcsum_nofold_simple_align, always_usable},
+#if defined(__x86_64__)
+    {"x64_128b", fastcsum_nofold_x64_128b, always_usable},
+    {"x64_64b", fastcsum_nofold_x64_64b, always_usable},
+    {"adx_v2", fastcsum_nofold_adx_v2, adx_usable},
+    {"avx2_v7", fastcsum_nofold_avx2_v7, avx2_usable},
+#endif
+    {"simple_opt", fastcsum_nofold_simple_opt, fastcsum_vector_usable},
+    {"vec256", fastcsum_nofold_vec256, fastcsum_vector_usable},
+    {"vec256_align", fastcsum_nofold_vec256_align, fastcsum_vector_usable},
+    {"vec128", fastcsum_nofold_vec128, fastcsum_vector_usable},
+    {"vec128_align", fastcsum_nofold_vec128_align, fastcsum_vector_usable},
+};
+
+extern "C" const struct fastcsum_kernel *fastcsum_kernels(size_t *n) {
+    *n = sizeof(kernels) / sizeof(kernels[0]);
+    return kernels;
+}
+
+extern "C" const struct fastcsum_kernel *fastcsum_kernel_find(const char *name) {
+    for (auto &k : kernels)
+        if (!strcmp(k.name, name))
+            return &k;
+    return nullptr;
+}
@@ -0,0 +1,43 @@
+#include "fastcsum-net.h"
+
+extern "C" int fastcsum_frag_add(struct fastcsum_frag *f, size_t offset, const uint8_t *data, size_t len, bool last) {
+    if (!len || len > SIZE_MAX - offset)
+        return -1;
+    auto end = offset + len;
+    if (f->total && end > f->total)
+        return -1;
+    if (last && ((f->total && end != f->total) || (f->nranges && f->ranges[f->nranges - 1].end > end)))
+        return -1;
+
+    unsigned int pos = 0;
+    while (pos < f->nranges && f->ranges[pos].start < offset)
+        pos++;
+    if ((pos > 0 && f->ranges[pos - 1].end > offset) || (pos < f->nranges && f->ranges[pos].start < end))
+        return -1;
+
+    bool join_left = pos > 0 && f->ranges[pos - 1].end == offset;
+    bool join_right = pos < f->nranges && f->ranges[pos].start == end;
+    if (join_left && join_right) {
+        f->ranges[pos - 1].end = f->ranges[pos].end;
+        for (auto i = pos + 1; i < f->nranges; i++)
+            f->ranges[i - 1] = f->ranges[i];
+        f->nranges--;
+    } else if (join_left) {
+        f->ranges[pos - 1].end = end;
+    } else if (join_right) {
+        f->ranges[pos].start = offset;
+    } else {
+        if (f->nranges == FASTCSUM_FRAG_MAX_RANGES)
+            return -1;
+        for (auto i = f->nranges; i > pos; i--)
+            f->ranges[i] = f->ranges[i - 1];
+        f->ranges[pos] = {offset, end};
+        f->nranges++;
+    }
+
+    f->sum = fastcsum_combine(f->sum, fastcsum_nofold(data, len, 0), offset);
+    f->received += len;
+    if (last)
+        f->total = end;
+    return f->total && f->received == f->total ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+#include "fastcsum-net.h"
+#include "addc.hpp"
+#include "netparse.hpp"
+
+template <bool fill>
+static unsigned int
+process_frame(uint8_t *frame, size_t len, fastcsum_nofold_fn fn, struct fastcsum_frame_info *info) {
+    fastcsum_frame_info tmp;
+    if (!info)
+        info = &tmp;
+    *info = {};
+
+    uint16_t ethertype;
+    size_t l3_offset;
+    if (!parse_l2(frame, len, ethertype, l3_offset))
+        return info->flags = FASTCSUM_FRAME_MALFORMED;
+    if (ethertype != ETHTYPE_IPV4 && ethertype != ETHTYPE_IPV6)
+        return info->flags = 0;
+
+    auto l3 = frame + l3_offset;
+    l3_info l3i;
+    if (!parse_l3(l3, len - l3_offset, ethertype, l3i))
+        return info->flags = FASTCSUM_FRAME_MALFORMED;
+    unsigned int flags = l3i.v6 ? FASTCSUM_FRAME_IPV6 : FASTCSUM_FRAME_IPV4;
+    info->l3_offset = l3_offset;
+    info->l4_offset = l3_offset + l3i.l4_offset;
+    info->l4_len = l3i.l4_len;
+    info->l4_proto = l3i.proto;
+
+    if (!l3i.v6) {
+        if (fill)
+            fastcsum_ipv4_hdr_generate(l3);
+        else if (!fastcsum_ipv4_hdr_verify(l3))
+            flags |= FASTCSUM_FRAME_BAD_L3;
+    }
+    if (l3i.fragment)
+        return info->flags = flags | FASTCSUM_FRAME_FRAGMENT;
+
+    size_t min_len;
+    int csum_offset = l4_csum_offset(l3i.proto, min_len);
+    if (csum_offset < 0 || (l3i.proto == PROTO_ICMP && l3i.v6) || (l3i.proto == PROTO_ICMPV6 && !l3i.v6))
+        return info->flags = flags;
+
+    auto l4 = l3 + l3i.l4_offset;
+    auto l4_len = l3i.l4_len;
+    if (l4_len < min_len)
+        return info->flags = flags | FASTCSUM_FRAME_MALFORMED;
+
+    size_t sum_len = l4_len;
+    switch (l3i.proto) {
+    case PROTO_TCP:
+        flags |= FASTCSUM_FRAME_TCP;
+        break;
+    case PROTO_UDP: {
+        flags |= FASTCSUM_FRAME_UDP;
+        size_t udp_len = load_be16(&l4[4]);
+        if (udp_len < 8 || udp_len > l4_len)
+            return info->flags = flags | FASTCSUM_FRAME_MALFORMED;
+        l4_len = sum_len = udp_len;
+        break;
+    }
+    case PROTO_UDPLITE: {
+        flags |= FASTCSUM_FRAME_UDPLITE;
+        size_t coverage = load_be16(&l4[4]);
+        if (!coverage)
+            coverage = l4_len;
+        if (coverage < 8 || coverage > l4_len)
+            return info->flags = flags | FASTCSUM_FRAME_MALFORMED;
+        sum_len = coverage;
+        break;
+    }
+    default:
+        flags |= FASTCSUM_FRAME_ICMP;
+        break;
+    }
+
+    auto field = reinterpret_cast<u16u *>(&l4[csum_offset]);
+    if (!fill && l3i.proto == PROTO_UDP && !l3i.v6 && *field == 0)
+        return info->flags = flags | FASTCSUM_FRAME_NO_L4_CSUM;
+
+    uint64_t pseudo = 0;
+    if (l3i.v6)
+        pseudo = fastcsum_nofold_pseudo_v6(l3i.saddr, l3i.daddr, l3i.proto, static_cast<uint32_t>(l4_len));
+    else if (l3i.proto != PROTO_ICMP)
+        pseudo = fastcsum_nofold_pseudo_v4(l3i.saddr, l3i.daddr, l3i.proto, static_cast<uint16_t>(l4_len));
+    auto ac = fn(l4, sum_len, pseudo);
+
+    if (fill) {
+        // subtract the old checksum instead of zeroing it first, avoiding a store-to-load round trip
+        auto csum = fastcsum_fold_complement(fastcsum_add(ac, static_cast<uint16_t>(~*field)));
+        if (!csum && (l3i.proto == PROTO_UDP || l3i.proto == PROTO_UDPLITE))
+            csum = 0xffff;
+        *field = csum;
+    } else if (fastcsum_fold_complement(ac)) {
+        flags |= FASTCSUM_FRAME_BAD_L4;
+    }
+    return info->flags = flags;
+}
+
+extern "C" unsigned int fastcsum_frame_verify(const uint8_t *frame, size_t len, struct fastcsum_frame_info *info) {
+    return process_frame<false>(const_cast<uint8_t *>(frame), len, fastcsum_nofold_best(), info);
+}
+
+extern "C" unsigned int fastcsum_frame_fill(uint8_t *frame, size_t len, struct fastcsum_frame_info *info) {
+    return process_frame<true>(frame, len, fastcsum_nofold_best(), info);
+}
+
+extern "C" size_t fastcsum_frame_verify_batch(
+    const uint8_t *const frames[],
+    const size_t lens[],
+    size_t n,
+    unsigned int flags[],
+    struct fastcsum_frame_info infos[]) {
+    auto fn = fastcsum_nofold_best();
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        flags[i] = process_frame<false>(const_cast<uint8_t *>(frames[i]), lens[i], fn, infos ? &infos[i] : nullptr);
+        bad += (flags[i] & FASTCSUM_FRAME_ERRORS) != 0;
+    }
+    return bad;
+}
+
+extern "C" void fastcsum_frame_fill_batch(
+    uint8_t *const frames[],
+    const size_t lens[],
+    size_t n,
+    unsigned int flags[],
+    struct fastcsum_frame_info infos[]) {
+    auto fn = fastcsum_nofold_best();
+    for (size_t i = 0; i < n; i++)
+        flags[i] = process_frame<true>(frames[i], lens[i], fn, infos ? &infos[i] : nullptr);
+}
@@ -0,0 +1,22 @@
+#include "fastcsum-net.h"
+#include "addc.hpp"
+
+extern "C" void
+fastcsum_gro_push(struct fastcsum_gro *g, uint64_t pseudo, const uint8_t *tcp, size_t tcp_len, size_t payload_len) {
+    // a verified segment sums to -0 with its pseudo-header, so its payload sums to ~(pseudo + header)
+    auto payload = ~fastcsum_nofold(tcp, tcp_len, pseudo);
+    g->payload_sum = fastcsum_combine(g->payload_sum, payload, g->payload_len);
+    g->payload_len += payload_len;
+    g->nsegs++;
+}
+
+extern "C" uint16_t fastcsum_gro_finish(
+    const struct fastcsum_gro *g,
+    uint64_t pseudo,
+    const uint8_t *tcp,
+    size_t tcp_len) {
+    auto ac = fastcsum_nofold(tcp, tcp_len, pseudo);
+    ac = fastcsum_add(ac, static_cast<uint16_t>(~*reinterpret_cast<const u16u *>(&tcp[16])));
+    ac = fastcsum_combine(ac, g->payload_sum, tcp_len);
+    return fastcsum_fold_complement(ac);
+}
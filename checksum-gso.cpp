@@ -0,0 +1,73 @@
+#include "fastcsum-net.h"
+#include "addc.hpp"
+#include "netparse.hpp"
+
+static constexpr uint8_t tcp_fin = 0x01;
+static constexpr uint8_t tcp_psh = 0x08;
+static constexpr uint8_t tcp_cwr = 0x80;
+
+extern "C" size_t fastcsum_nofold_segments(const uint8_t *ptr, size_t size, size_t seg_size, uint64_t out[]) {
+    if (!seg_size)
+        return 0;
+    auto fn = fastcsum_nofold_best();
+    size_t n = 0;
+    for (size_t off = 0; off < size; off += seg_size) {
+        auto todo = size - off < seg_size ? size - off : seg_size;
+        out[n++] = fn(ptr + off, todo, 0);
+    }
+    return n;
+}
+
+extern "C" size_t fastcsum_gso_tcp(
+    bool v6,
+    const uint8_t *saddr,
+    const uint8_t *daddr,
+    const uint8_t *tcp,
+    size_t tcp_len,
+    const uint8_t *payload,
+    size_t len,
+    size_t mss,
+    uint16_t csums[]) {
+    if (!mss || tcp_len < 20)
+        return 0;
+    auto fn = fastcsum_nofold_best();
+
+    // pseudo-header and TCP header without the length, sequence number, flags and checksum; the per-segment values of
+    // those are added back below
+    auto seq_field = *reinterpret_cast<const u32u *>(&tcp[4]);
+    auto flags_field = *reinterpret_cast<const u16u *>(&tcp[12]);
+    auto csum_field = *reinterpret_cast<const u16u *>(&tcp[16]);
+    auto base = v6 ? fastcsum_nofold_pseudo_v6(saddr, daddr, PROTO_TCP, 0)
+                   : fastcsum_nofold_pseudo_v4(saddr, daddr, PROTO_TCP, 0);
+    base = fn(tcp, tcp_len, base);
+    base = fastcsum_add(base, static_cast<uint32_t>(~seq_field));
+    base = fastcsum_add(base, static_cast<uint16_t>(~flags_field));
+    base = fastcsum_add(base, static_cast<uint16_t>(~csum_field));
+
+    uint32_t seq = net32(seq_field);
+    uint8_t doff = tcp[12];
+    uint8_t flags = tcp[13];
+    // a super-packet without payload still yields one segment
+    size_t nsegs = len ? (len + mss - 1) / mss : 1;
+    for (size_t i = 0; i < nsegs; i++) {
+        auto off = i * mss;
+        auto todo = len - off < mss ? len - off : mss;
+        bool first = i == 0;
+        bool last = i == nsegs - 1;
+
+        uint8_t seg_flags = flags;
+        if (!first)
+            seg_flags &= ~tcp_cwr;
+        if (!last)
+            seg_flags &= ~(tcp_fin | tcp_psh);
+        uint8_t seg_word[2] = {doff, seg_flags};
+
+        auto ac = fn(payload + off, todo, base);
+        // the pseudo-header length occupies whole bytes, so adding it separately is the same as summing it in place
+        ac = fastcsum_add(ac, net32(static_cast<uint32_t>(tcp_len + todo)));
+        ac = fastcsum_add(ac, net32(seq + static_cast<uint32_t>(off)));
+        ac = fastcsum_add(ac, *reinterpret_cast<const u16u *>(seg_word));
+        csums[i] = fastcsum_fold_complement(ac);
+    }
+    return nsegs;
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <vector>
+
+#include "fastcsum-index.h"
+
+struct fastcsum_index {
+    const uint8_t *ptr;
+    size_t size;
+    size_t leaf_size;
+    size_t nleaves;
+    // leaf count rounded up to a power of 2; node 1 is the root and leaves start at index `cap`
+    size_t cap;
+    fastcsum_nofold_fn fn;
+    // each node's sum is relative to the first byte it covers
+    std::vector<uint64_t> tree;
+};
+
+static void query_node(
+    const fastcsum_index *idx,
+    size_t node,
+    size_t first,
+    size_t span,
+    size_t start,
+    size_t end,
+    uint64_t &ac) {
+    auto b0 = first * idx->leaf_size;
+    auto b1 = std::min((first + span) * idx->leaf_size, idx->size);
+    if (b0 >= end || b1 <= start || b0 >= b1)
+        return;
+    if (start <= b0 && b1 <= end) {
+        ac = fastcsum_combine(ac, idx->tree[node], b0 - start);
+        return;
+    }
+    if (span == 1) {
+        auto s = std::max(b0, start);
+        auto e = std::min(b1, end);
+        ac = fastcsum_combine(ac, idx->fn(idx->ptr + s, e - s, 0), s - start);
+        return;
+    }
+    query_node(idx, 2 * node, first, span / 2, start, end, ac);
+    query_node(idx, 2 * node + 1, first + span / 2, span / 2, start, end, ac);
+}
+
+extern "C" struct fastcsum_index *fastcsum_index_create(const uint8_t *ptr, size_t size, size_t leaf_size) {
+    if (!leaf_size)
+        return nullptr;
+    fastcsum_index *idx = nullptr;
+    try {
+        idx = new fastcsum_index;
+        idx->ptr = ptr;
+        idx->size = size;
+        idx->leaf_size = leaf_size;
+        idx->nleaves = (size + leaf_size - 1) / leaf_size;
+        idx->cap = 1;
+        while (idx->cap < idx->nleaves)
+            idx->cap *= 2;
+        idx->fn = fastcsum_nofold_best();
+        idx->tree.assign(2 * idx->cap, 0);
+    } catch (...) {
+        delete idx;
+        return nullptr;
+    }
+    fastcsum_index_update(idx, 0, size);
+    return idx;
+}
+
+extern "C" void fastcsum_index_destroy(struct fastcsum_index *idx) {
+    delete idx;
+}
+
+extern "C" void fastcsum_index_update(struct fastcsum_index *idx, size_t offset, size_t len) {
+    if (!len || offset >= idx->size)
+        return;
+    auto end = len > idx->size - offset ? idx->size : offset + len;
+    auto lo = offset / idx->leaf_size;
+    auto hi = (end - 1) / idx->leaf_size;
+    for (auto i = lo; i <= hi; i++) {
+        auto start = i * idx->leaf_size;
+        auto todo = std::min(idx->leaf_size, idx->size - start);
+        idx->tree[idx->cap + i] = idx->fn(idx->ptr + start, todo, 0);
+    }
+
+    // the right child of a node with `span` leaves starts span / 2 leaves in
+    lo += idx->cap;
+    hi += idx->cap;
+    for (size_t span = 2; lo > 1; span *= 2) {
+        lo /= 2;
+        hi /= 2;
+        for (auto n = lo; n <= hi; n++)
+            idx->tree[n] = fastcsum_combine(idx->tree[2 * n], idx->tree[2 * n + 1], span / 2 * idx->leaf_size);
+    }
+}
+
+extern "C" uint64_t fastcsum_index_query(const struct fastcsum_index *idx, size_t start, size_t end) {
+    end = std::min(end, idx->size);
+    if (start >= end)
+        return 0;
+    if (start == 0 && end == idx->size)
+        return idx->tree[1];
+    uint64_t ac = 0;
+    query_node(idx, 1, 0, idx->cap, start, end, ac);
+    return ac;
+}
@@ -0,0 +1,71 @@
+#include "fastcsum-net.h"
+#include "addc.hpp"
+
+extern "C" uint64_t fastcsum_nofold_ipv4_hdr(const uint8_t *hdr) {
+    uint64_t ac;
+    uint64_t carry;
+    ac = addc(
+        *reinterpret_cast<const u64u *>(&hdr[0]),
+        *reinterpret_cast<const u64u *>(&hdr[8]),
+        0,
+        &carry);
+    ac += carry;
+    ac = addc(ac, static_cast<uint64_t>(*reinterpret_cast<const u32u *>(&hdr[16])), 0, &carry);
+    ac += carry;
+
+    // options: at most 40 bytes of dwords, which cannot overflow a separate accumulator
+    unsigned int ihl = hdr[0] & 0xf;
+    if (ihl > 5) {
+        uint64_t opts = 0;
+        for (unsigned int i = 5; i < ihl; i++)
+            opts += *reinterpret_cast<const u32u *>(&hdr[i * 4]);
+        ac = fastcsum_add(ac, opts);
+    }
+    return ac;
+}
+
+extern "C" bool fastcsum_ipv4_hdr_verify(const uint8_t *hdr) {
+    return (hdr[0] & 0xf) >= 5 && fastcsum_fold_complement(fastcsum_nofold_ipv4_hdr(hdr)) == 0;
+}
+
+extern "C" void fastcsum_ipv4_hdr_generate(uint8_t *hdr) {
+    // subtract the old checksum instead of zeroing it first, avoiding a store-to-load round trip
+    auto old = *reinterpret_cast<const u16u *>(&hdr[10]);
+    auto ac = fastcsum_add(fastcsum_nofold_ipv4_hdr(hdr), static_cast<uint16_t>(~old));
+    *reinterpret_cast<u16u *>(&hdr[10]) = fastcsum_fold_complement(ac);
+}
+
+extern "C" size_t fastcsum_ipv4_hdr_verify_batch_generic(const uint8_t *const hdrs[], size_t n, uint64_t invalid[]) {
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64 && i + j < n; j++)
+            word |= static_cast<uint64_t>(!fastcsum_ipv4_hdr_verify(hdrs[i + j])) << j;
+        invalid[i / 64] = word;
+        bad += __builtin_popcountll(word);
+    }
+    return bad;
+}
+
+extern "C" void fastcsum_ipv4_hdr_generate_batch_generic(uint8_t *const hdrs[], size_t n) {
+    for (size_t i = 0; i < n; i++)
+        fastcsum_ipv4_hdr_generate(hdrs[i]);
+}
+
+extern "C" size_t fastcsum_ipv4_hdr_verify_batch(const uint8_t *const hdrs[], size_t n, uint64_t invalid[]) {
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable())
+        return fastcsum_ipv4_hdr_verify_batch_avx2(hdrs, n, invalid);
+#endif
+    return fastcsum_ipv4_hdr_verify_batch_generic(hdrs, n, invalid);
+}
+
+extern "C" void fastcsum_ipv4_hdr_generate_batch(uint8_t *const hdrs[], size_t n) {
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable()) {
+        fastcsum_ipv4_hdr_generate_batch_avx2(hdrs, n);
+        return;
+    }
+#endif
+    fastcsum_ipv4_hdr_generate_batch_generic(hdrs, n);
+}
@@ -0,0 +1,57 @@
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "fastcsum-net.h"
+#include "addc.hpp"
+#include "netparse.hpp"
+
+// Sums the 32 bytes of an IPv6 address pair.
+static inline uint64_t sum_addrs_v6(const uint8_t *saddr, const uint8_t *daddr) {
+#if defined(__x86_64__)
+    auto a = _mm_loadu_si128(reinterpret_cast<const __m128i_u *>(saddr));
+    auto b = _mm_loadu_si128(reinterpret_cast<const __m128i_u *>(daddr));
+    auto zero = _mm_setzero_si128();
+    // zero-extended dwords cannot overflow the qword lanes
+    auto q = _mm_add_epi64(_mm_unpacklo_epi32(a, zero), _mm_unpackhi_epi32(a, zero));
+    q = _mm_add_epi64(q, _mm_unpacklo_epi32(b, zero));
+    q = _mm_add_epi64(q, _mm_unpackhi_epi32(b, zero));
+    q = _mm_add_epi64(q, _mm_unpackhi_epi64(q, q));
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(q));
+#else
+    uint64_t ac = 0;
+    for (size_t i = 0; i < 16; i += 4) {
+        ac += *reinterpret_cast<const u32u *>(&saddr[i]);
+        ac += *reinterpret_cast<const u32u *>(&daddr[i]);
+    }
+    return ac;
+#endif
+}
+
+extern "C" uint64_t fastcsum_nofold_pseudo_v4(
+    const uint8_t saddr[4],
+    const uint8_t daddr[4],
+    uint8_t proto,
+    uint16_t len) {
+    uint64_t ac = *reinterpret_cast<const u32u *>(saddr);
+    ac += *reinterpret_cast<const u32u *>(daddr);
+    ac += net32((static_cast<uint32_t>(proto) << 16) | len);
+    return ac;
+}
+
+extern "C" uint64_t
+fastcsum_nofold_pseudo_v6(const uint8_t saddr[16], const uint8_t daddr[16], uint8_t proto, uint32_t len) {
+    return sum_addrs_v6(saddr, daddr) + net32(len) + net32(proto);
+}
+
+extern "C" uint16_t
+fastcsum_l4_v4(const uint8_t saddr[4], const uint8_t daddr[4], uint8_t proto, const uint8_t *l4, size_t len) {
+    auto pseudo = fastcsum_nofold_pseudo_v4(saddr, daddr, proto, static_cast<uint16_t>(len));
+    return fastcsum_fold_complement(fastcsum_nofold(l4, len, pseudo));
+}
+
+extern "C" uint16_t
+fastcsum_l4_v6(const uint8_t saddr[16], const uint8_t daddr[16], uint8_t proto, const uint8_t *l4, size_t len) {
+    auto pseudo = fastcsum_nofold_pseudo_v6(saddr, daddr, proto, static_cast<uint32_t>(len));
+    return fastcsum_fold_complement(fastcsum_nofold(l4, len, pseudo));
+}
@@ -0,0 +1,68 @@
+#include "fastcsum-net.h"
+#include "addc.hpp"
+#include "netparse.hpp"
+
+static bool parse_ip(const uint8_t *l3, size_t len, l3_info &info) {
+    if (!len)
+        return false;
+    return parse_l3(l3, len, (l3[0] >> 4) == 6 ? ETHTYPE_IPV6 : ETHTYPE_IPV4, info);
+}
+
+static uint64_t pseudo_sum(const l3_info &info, size_t l4_len) {
+    if (info.v6)
+        return fastcsum_nofold_pseudo_v6(info.saddr, info.daddr, info.proto, static_cast<uint32_t>(l4_len));
+    return fastcsum_nofold_pseudo_v4(info.saddr, info.daddr, info.proto, static_cast<uint16_t>(l4_len));
+}
+
+// Returns the sum of the inner L4 segment, from its pseudo-header if its checksum is known to be filled in.
+static uint64_t inner_l4_sum(const uint8_t *l4, const l3_info &info, size_t l4_len, fastcsum_nofold_fn fn) {
+    size_t min_len;
+    int csum_offset = l4_csum_offset(info.proto, min_len);
+    bool lco = !info.fragment && csum_offset >= 0 && l4_len >= min_len;
+    if (lco && info.proto == PROTO_UDP)
+        // a zero UDP checksum over IPv4 means no checksum
+        lco = info.v6 || *reinterpret_cast<const u16u *>(&l4[csum_offset]);
+    if (lco && info.proto == PROTO_UDPLITE) {
+        // partial coverage leaves the rest of the segment out of the checksum
+        size_t coverage = load_be16(&l4[4]);
+        lco = !coverage || coverage == l4_len;
+    }
+    if (lco && info.proto == PROTO_ICMP)
+        return fastcsum_lco_sum(0);
+    if (lco && (info.proto != PROTO_ICMPV6 || info.v6))
+        return fastcsum_lco_sum(pseudo_sum(info, l4_len));
+    return fn(l4, l4_len, 0);
+}
+
+extern "C" int fastcsum_encap_udp_lco(uint8_t *outer_l3, size_t len, size_t inner_l3_offset) {
+    l3_info outer;
+    if (!parse_ip(outer_l3, len, outer) || outer.proto != PROTO_UDP || outer.fragment || outer.l4_len < 8)
+        return -1;
+    auto udp = outer_l3 + outer.l4_offset;
+    size_t udp_len = load_be16(&udp[4]);
+    if (udp_len < 8 || udp_len > outer.l4_len || inner_l3_offset < outer.l4_offset + 8)
+        return -1;
+
+    // offsets below are relative to the outer UDP header
+    size_t inner_l3 = inner_l3_offset - outer.l4_offset;
+    if (inner_l3 > udp_len)
+        return -1;
+    l3_info inner;
+    if (!parse_ip(udp + inner_l3, udp_len - inner_l3, inner))
+        return -1;
+    size_t inner_l4 = inner_l3 + inner.l4_offset;
+    size_t inner_end = inner_l4 + inner.l4_len;
+
+    auto fn = fastcsum_nofold_best();
+    auto field = reinterpret_cast<u16u *>(&udp[6]);
+    // outer UDP header up to the inner L4 header, without the old outer checksum
+    auto ac = fn(udp, inner_l4, pseudo_sum(outer, udp_len));
+    ac = fastcsum_add(ac, static_cast<uint16_t>(~*field));
+    ac = fastcsum_combine(ac, inner_l4_sum(udp + inner_l4, inner, inner.l4_len, fn), inner_l4);
+    // trailing bytes past the inner packet, if any
+    ac = fastcsum_combine(ac, fn(udp + inner_end, udp_len - inner_end, 0), inner_end);
+
+    auto csum = fastcsum_fold_complement(ac);
+    *field = csum ? csum : 0xffff;
+    return 0;
+}
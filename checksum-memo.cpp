@@ -0,0 +1,121 @@
+#include <list>
+#include <unordered_map>
+
+#include "fastcsum-memo.h"
+
+namespace {
+
+struct memo_key {
+    uint64_t buffer_id;
+    size_t chunk;
+
+    bool operator==(const memo_key &other) const {
+        return buffer_id == other.buffer_id && chunk == other.chunk;
+    }
+};
+
+struct memo_key_hash {
+    size_t operator()(const memo_key &key) const {
+        return static_cast<size_t>((key.buffer_id * 0x9e3779b97f4a7c15ULL) ^ key.chunk);
+    }
+};
+
+struct memo_entry {
+    memo_key key;
+    uint64_t sum;
+};
+
+}
+
+struct fastcsum_memo {
+    size_t chunk_size;
+    size_t max_entries;
+    fastcsum_nofold_fn fn;
+    // most recently used first
+    std::list<memo_entry> lru;
+    std::unordered_map<memo_key, std::list<memo_entry>::iterator, memo_key_hash> map;
+};
+
+static uint64_t chunk_sum(fastcsum_memo *memo, uint64_t buffer_id, const uint8_t *base, size_t chunk) {
+    auto it = memo->map.find({buffer_id, chunk});
+    if (it != memo->map.end()) {
+        memo->lru.splice(memo->lru.begin(), memo->lru, it->second);
+        return it->second->sum;
+    }
+
+    auto sum = memo->fn(base + chunk * memo->chunk_size, memo->chunk_size, 0);
+    if (memo->map.size() >= memo->max_entries) {
+        memo->map.erase(memo->lru.back().key);
+        memo->lru.pop_back();
+    }
+    memo->lru.push_front({{buffer_id, chunk}, sum});
+    memo->map.emplace(memo_key{buffer_id, chunk}, memo->lru.begin());
+    return sum;
+}
+
+extern "C" struct fastcsum_memo *fastcsum_memo_create(size_t chunk_size, size_t max_entries) {
+    if (!chunk_size || !max_entries)
+        return nullptr;
+    fastcsum_memo *memo = nullptr;
+    try {
+        memo = new fastcsum_memo;
+        memo->chunk_size = chunk_size;
+        memo->max_entries = max_entries;
+        memo->fn = fastcsum_nofold_best();
+        memo->map.reserve(max_entries);
+    } catch (...) {
+        delete memo;
+        return nullptr;
+    }
+    return memo;
+}
+
+extern "C" void fastcsum_memo_destroy(struct fastcsum_memo *memo) {
+    delete memo;
+}
+
+extern "C" uint64_t
+fastcsum_memo_sum(struct fastcsum_memo *memo, uint64_t buffer_id, const uint8_t *base, size_t offset, size_t len) {
+    auto cs = memo->chunk_size;
+    auto end = offset + len;
+    auto first = (offset + cs - 1) / cs;
+    auto last = end / cs;
+    if (first >= last)
+        return memo->fn(base + offset, len, 0);
+
+    uint64_t ac = memo->fn(base + offset, first * cs - offset, 0);
+    for (auto chunk = first; chunk < last; chunk++)
+        ac = fastcsum_combine(ac, chunk_sum(memo, buffer_id, base, chunk), chunk * cs - offset);
+    return fastcsum_combine(ac, memo->fn(base + last * cs, end - last * cs, 0), last * cs - offset);
+}
+
+extern "C" void fastcsum_memo_invalidate(struct fastcsum_memo *memo, uint64_t buffer_id, size_t offset, size_t len) {
+    if (!len)
+        return;
+    auto first = offset / memo->chunk_size;
+    auto last = (len > SIZE_MAX - offset ? SIZE_MAX : offset + len - 1) / memo->chunk_size;
+
+    // look up each chunk of short ranges, scan everything for long ones
+    if (last - first < memo->map.size()) {
+        for (auto chunk = first; chunk <= last; chunk++) {
+            auto it = memo->map.find({buffer_id, chunk});
+            if (it != memo->map.end()) {
+                memo->lru.erase(it->second);
+                memo->map.erase(it);
+            }
+        }
+        return;
+    }
+    for (auto it = memo->lru.begin(); it != memo->lru.end();) {
+        if (it->key.buffer_id == buffer_id && it->key.chunk >= first && it->key.chunk <= last) {
+            memo->map.erase(it->key);
+            it = memo->lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+extern "C" size_t fastcsum_memo_entries(const struct fastcsum_memo *memo) {
+    return memo->map.size();
+}
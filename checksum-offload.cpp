@@ -0,0 +1,219 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "fastcsum-offload.h"
+#include "threadpool.hpp"
+
+static constexpr size_t cache_line = 64;
+static constexpr size_t worker_batch = 32;
+static constexpr unsigned int spins_before_yield = 1024;
+
+static inline void cpu_relax() {
+#if defined(__i386__) || defined(__x86_64__)
+    _mm_pause();
+#endif
+}
+
+static size_t round_up_pow2(size_t n) {
+    size_t r = 2;
+    while (r < n)
+        r <<= 1;
+    return r;
+}
+
+namespace {
+
+// Lock-free single-producer single-consumer ring. Each side caches the other side's index to avoid
+// bouncing its cache line on every operation.
+class spsc_ring {
+public:
+    explicit spsc_ring(size_t capacity) : slots(new fastcsum_offload_desc[capacity]), mask(capacity - 1) {
+    }
+
+    bool push(const fastcsum_offload_desc &desc) {
+        auto t = tail.load(std::memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t - cached_head > mask)
+                return false;
+        }
+        slots[t & mask] = desc;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t pop(fastcsum_offload_desc *out, size_t n) {
+        auto h = head.load(std::memory_order_relaxed);
+        if (cached_tail - h < n)
+            cached_tail = tail.load(std::memory_order_acquire);
+        if (cached_tail - h < n)
+            n = cached_tail - h;
+        for (size_t i = 0; i < n; i++)
+            out[i] = slots[(h + i) & mask];
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    std::unique_ptr<fastcsum_offload_desc[]> slots;
+    size_t mask;
+    char pad0[cache_line];
+    // producer side
+    std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+    char pad1[cache_line];
+    // consumer side
+    std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+    char pad2[cache_line];
+};
+
+// Lock-free multi-producer single-consumer ring. Producers never wait for space: the submitter never keeps more
+// descriptors in flight than the ring can hold.
+class mpsc_ring {
+public:
+    explicit mpsc_ring(size_t capacity) : slots(new slot[capacity]()), mask(capacity - 1) {
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    void push(const fastcsum_offload_desc *descs, size_t n) {
+        auto pos = tail.fetch_add(n, std::memory_order_relaxed);
+        for (size_t i = 0; i < n; i++) {
+            auto &s = slots[(pos + i) & mask];
+            s.desc = descs[i];
+            s.seq.store(pos + i + 1, std::memory_order_release);
+        }
+    }
+
+    size_t pop(fastcsum_offload_desc *out, size_t n) {
+        size_t i;
+        for (i = 0; i < n; i++) {
+            auto &s = slots[head & mask];
+            if (s.seq.load(std::memory_order_acquire) != head + 1)
+                break;
+            out[i] = s.desc;
+            head++;
+        }
+        return i;
+    }
+
+private:
+    struct slot {
+        std::atomic<size_t> seq;
+        fastcsum_offload_desc desc;
+    };
+
+    std::unique_ptr<slot[]> slots;
+    size_t mask;
+    char pad0[cache_line];
+    std::atomic<size_t> tail{0};
+    char pad1[cache_line];
+    size_t head = 0;
+};
+
+} // namespace
+
+struct fastcsum_offload {
+    fastcsum_offload(unsigned int nworkers, size_t depth) : completions(round_up_pow2(nworkers * depth)) {
+        for (unsigned int i = 0; i < nworkers; i++)
+            rings.emplace_back(new spsc_ring(depth));
+    }
+
+    void worker_main(unsigned int index, fastcsum_affinity affinity) {
+        pin_thread(affinity, index + 1);
+
+        auto fn = fastcsum_nofold_best();
+        auto &ring = *rings[index];
+        fastcsum_offload_desc batch[worker_batch];
+        unsigned int idle = 0;
+        while (!stopping.load(std::memory_order_relaxed)) {
+            auto n = ring.pop(batch, worker_batch);
+            if (!n) {
+                if (++idle < spins_before_yield) {
+                    cpu_relax();
+                } else {
+                    idle = 0;
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            idle = 0;
+            for (size_t i = 0; i < n; i++)
+                batch[i].result = fn(batch[i].ptr, batch[i].len, batch[i].initial);
+            completions.push(batch, n);
+        }
+    }
+
+    std::vector<std::unique_ptr<spsc_ring>> rings;
+    mpsc_ring completions;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping{false};
+    // submitter side
+    size_t inflight = 0;
+    size_t next_ring = 0;
+};
+
+extern "C" struct fastcsum_offload *
+fastcsum_offload_create(unsigned int nworkers, size_t depth, enum fastcsum_affinity affinity) {
+    if (!nworkers || !depth)
+        return nullptr;
+    depth = round_up_pow2(depth);
+
+    fastcsum_offload *q = nullptr;
+    try {
+        q = new fastcsum_offload(nworkers, depth);
+        for (unsigned int i = 0; i < nworkers; i++)
+            q->threads.emplace_back(&fastcsum_offload::worker_main, q, i, affinity);
+    } catch (...) {
+        fastcsum_offload_destroy(q);
+        return nullptr;
+    }
+    return q;
+}
+
+extern "C" void fastcsum_offload_destroy(struct fastcsum_offload *q) {
+    if (!q)
+        return;
+    q->stopping.store(true, std::memory_order_relaxed);
+    for (auto &t : q->threads)
+        t.join();
+    delete q;
+}
+
+extern "C" size_t fastcsum_offload_submit(
+    struct fastcsum_offload *q,
+    const struct fastcsum_offload_desc *descs,
+    size_t n) {
+    auto nrings = q->rings.size();
+    size_t done = 0;
+    while (done < n && q->inflight < q->completions.capacity()) {
+        size_t tries = 0;
+        while (!q->rings[q->next_ring]->push(descs[done])) {
+            q->next_ring = (q->next_ring + 1) % nrings;
+            if (++tries == nrings)
+                return done;
+        }
+        q->next_ring = (q->next_ring + 1) % nrings;
+        q->inflight++;
+        done++;
+    }
+    return done;
+}
+
+extern "C" size_t fastcsum_offload_poll(struct fastcsum_offload *q, struct fastcsum_offload_desc *out, size_t n) {
+    auto done = q->completions.pop(out, n);
+    q->inflight -= done;
+    return done;
+}
+
+extern "C" size_t fastcsum_offload_inflight(const struct fastcsum_offload *q) {
+    return q->inflight;
+}
@@ -0,0 +1,37 @@
+#include <vector>
+
+#include "fastcsum.h"
+#include "threadpool.hpp"
+
+// Below this many bytes per thread, waking up workers costs more than it saves.
+static constexpr size_t min_parallel_chunk = 256 * 1024;
+static constexpr uintptr_t cache_line = 64;
+
+extern "C" uint64_t fastcsum_nofold_parallel(const uint8_t *ptr, size_t size, uint64_t initial, unsigned int nthreads) {
+    nthreads = shared_pool_threads(nthreads);
+    if (size / min_parallel_chunk < nthreads)
+        nthreads = static_cast<unsigned int>(size / min_parallel_chunk);
+    if (nthreads <= 1)
+        return fastcsum_nofold(ptr, size, initial);
+
+    // chunk boundaries are placed on cache line-aligned addresses so that no line is shared between threads
+    auto base = reinterpret_cast<uintptr_t>(ptr);
+    std::vector<size_t> offsets(nthreads + 1);
+    offsets[0] = 0;
+    for (unsigned int i = 1; i < nthreads; i++) {
+        auto split = (base + size / nthreads * i + cache_line - 1) & ~(cache_line - 1);
+        offsets[i] = split - base;
+    }
+    offsets[nthreads] = size;
+
+    auto fn = fastcsum_nofold_best();
+    std::vector<uint64_t> sums(nthreads);
+    shared_pool_run(nthreads, [&](unsigned int i) {
+        sums[i] = fn(ptr + offsets[i], offsets[i + 1] - offsets[i], 0);
+    });
+
+    uint64_t ac = initial;
+    for (unsigned int i = 0; i < nthreads; i++)
+        ac = fastcsum_combine(ac, sums[i], offsets[i]);
+    return ac;
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+
+#include "fastcsum.h"
+
+extern "C" void fastcsum_nofold_ranges(
+    const uint8_t *ptr,
+    size_t size,
+    const size_t starts[],
+    const size_t ends[],
+    size_t n,
+    uint64_t out[]) {
+    auto end_of = [&](size_t i) { return std::min(ends[i], size); };
+
+    // every range boundary splits the union into elementary segments that are each summed once
+    size_t pos = SIZE_MAX;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = 0;
+        if (starts[i] < end_of(i))
+            pos = std::min(pos, starts[i]);
+    }
+
+    // Only a handful of ranges in practice: rescanning them for the boundary after each segment needs no allocation.
+    // Segments are summed on first use, so gaps between ranges are never read; assembling ranges from segments rather
+    // than subtracting prefix sums keeps results identical to a direct sum, including the choice between +0 and -0.
+    auto fn = fastcsum_nofold_best();
+    while (pos != SIZE_MAX) {
+        size_t next = SIZE_MAX;
+        for (size_t i = 0; i < n; i++) {
+            auto end = end_of(i);
+            if (starts[i] >= end)
+                continue;
+            if (starts[i] > pos)
+                next = std::min(next, starts[i]);
+            if (end > pos)
+                next = std::min(next, end);
+        }
+        if (next == SIZE_MAX)
+            break;
+        bool summed = false;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (starts[i] > pos || end_of(i) < next || starts[i] >= end_of(i))
+                continue;
+            if (!summed) {
+                sum = fn(ptr + pos, next - pos, 0);
+                summed = true;
+            }
+            out[i] = fastcsum_combine(out[i], sum, pos - starts[i]);
+        }
+        pos = next;
+    }
+}
@@ -0,0 +1,39 @@
+#include "fastcsum.h"
+
+extern "C" uint64_t fastcsum_nofold_skip(
+    const uint8_t *ptr,
+    size_t size,
+    uint64_t initial,
+    const size_t skip_offsets[],
+    const size_t skip_lens[],
+    size_t n) {
+    auto fn = fastcsum_nofold_best();
+    if (!n)
+        return fn(ptr, size, initial);
+
+    auto skip_end = [&](size_t i) {
+        return skip_lens[i] > size - skip_offsets[i] ? size : skip_offsets[i] + skip_lens[i];
+    };
+
+    // Usually one or two fields: rescanning the unsorted ranges at each step is cheaper than sorting a copy, and
+    // needs no allocation. Each step either sums the gap up to the next range or moves past the ranges at `pos`.
+    uint64_t ac = initial;
+    size_t pos = 0;
+    while (pos < size) {
+        size_t next = size;
+        for (size_t i = 0; i < n; i++)
+            if (skip_offsets[i] < next && skip_lens[i] && skip_offsets[i] < size && skip_end(i) > pos)
+                next = skip_offsets[i];
+        if (next > pos) {
+            ac = fastcsum_combine(ac, fn(ptr + pos, next - pos, 0), pos);
+            pos = next;
+            continue;
+        }
+        size_t end = pos;
+        for (size_t i = 0; i < n; i++)
+            if (skip_lens[i] && skip_offsets[i] <= pos && skip_end(i) > end)
+                end = skip_end(i);
+        pos = end;
+    }
+    return ac;
+}
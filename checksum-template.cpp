@@ -0,0 +1,68 @@
+#include <algorithm>
+
+#include "fastcsum.h"
+#include "addc.hpp"
+
+extern "C" bool fastcsum_template_init(
+    struct fastcsum_template *t,
+    const uint8_t *tmpl,
+    size_t len,
+    const size_t offsets[],
+    const size_t lens[],
+    size_t nfields) {
+    if (nfields > FASTCSUM_TEMPLATE_MAX_FIELDS)
+        return false;
+
+    t->len = len;
+    t->nfields = nfields;
+    for (size_t i = 0; i < nfields; i++) {
+        if (offsets[i] > len || lens[i] > len - offsets[i])
+            return false;
+        t->fields[i].offset = offsets[i];
+        t->fields[i].len = lens[i];
+        if (lens[i] >= 8)
+            t->fields[i].mask = lens[i] == 8 ? ~uint64_t(0) : 0;
+        else if (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+            t->fields[i].mask = ~(~uint64_t(0) >> (lens[i] * 8));
+        else
+            t->fields[i].mask = ~(~uint64_t(0) << (lens[i] * 8));
+    }
+    std::sort(t->fields, t->fields + nfields, [](const decltype(t->fields[0]) &a, const decltype(t->fields[0]) &b) {
+        return a.offset < b.offset;
+    });
+
+    // sum the constant runs between fields
+    auto fn = fastcsum_nofold_best();
+    uint64_t ac = 0;
+    size_t pos = 0;
+    for (size_t i = 0; i < nfields; i++) {
+        if (t->fields[i].offset < pos)
+            return false;
+        ac = fastcsum_combine(ac, fn(tmpl + pos, t->fields[i].offset - pos, 0), pos);
+        pos = t->fields[i].offset + t->fields[i].len;
+    }
+    t->base = fastcsum_combine(ac, fn(tmpl + pos, len - pos, 0), pos);
+    return true;
+}
+
+extern "C" uint64_t fastcsum_template_sum(const struct fastcsum_template *t, const uint8_t *pkt) {
+    uint64_t ac = t->base;
+    for (size_t i = 0; i < t->nfields; i++) {
+        auto off = t->fields[i].offset;
+        auto len = t->fields[i].len;
+        auto mask = t->fields[i].mask;
+        uint64_t val;
+        if (mask && off + 8 <= t->len) {
+            // bytes outside the field are masked to zero, which does not change the sum
+            val = *reinterpret_cast<const u64u *>(pkt + off) & mask;
+        } else if (len < 8) {
+            val = 0;
+            for (size_t j = 0; j < len; j++)
+                reinterpret_cast<uint8_t *>(&val)[j] = pkt[off + j];
+        } else {
+            val = fastcsum_nofold(pkt + off, len, 0);
+        }
+        ac = fastcsum_combine(ac, val, off);
+    }
+    return ac;
+}
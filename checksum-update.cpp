@@ -0,0 +1,109 @@
+#include <cstring>
+
+#include "fastcsum.h"
+
+// 16 bytes wide so that no build passes a vector wider than the baseline ISA by value
+using u32x4 [[gnu::vector_size(16)]] = uint32_t;
+
+static constexpr size_t rewrite_chunk = 64;
+
+[[gnu::always_inline]] static inline u32x4 fold16_vec(u32x4 v) {
+    v = (v & 0xffff) + (v >> 16);
+    v = (v & 0xffff) + (v >> 16);
+    return v;
+}
+
+extern "C" uint16_t
+fastcsum_update_range(uint16_t csum, const uint8_t *old_bytes, const uint8_t *new_bytes, size_t len, size_t offset) {
+    auto fn = fastcsum_nofold_best();
+    // ~x is the 1's complement negation of an unfolded sum since 2^64 - 1 is a multiple of 2^16 - 1
+    auto delta = fastcsum_add(~fn(old_bytes, len, 0), fn(new_bytes, len, 0));
+    return fastcsum_fold_complement(fastcsum_combine(static_cast<uint16_t>(~csum), delta, offset));
+}
+
+extern "C" void fastcsum_update16_batch(
+    uint16_t csums[],
+    const uint16_t old_vals[],
+    const uint16_t new_vals[],
+    size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        u32x4 c, o, v;
+        for (size_t j = 0; j < 4; j++) {
+            c[j] = csums[i + j];
+            o[j] = old_vals[i + j];
+            v[j] = new_vals[i + j];
+        }
+        auto s = fold16_vec((~c & 0xffff) + (~o & 0xffff) + v);
+        for (size_t j = 0; j < 4; j++)
+            csums[i + j] = static_cast<uint16_t>(~s[j]);
+    }
+    for (; i < n; i++)
+        csums[i] = fastcsum_update16(csums[i], old_vals[i], new_vals[i]);
+}
+
+extern "C" void fastcsum_update32_batch(
+    uint16_t csums[],
+    const uint32_t old_vals[],
+    const uint32_t new_vals[],
+    size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        u32x4 c, o, v;
+        for (size_t j = 0; j < 4; j++) {
+            c[j] = csums[i + j];
+            o[j] = old_vals[i + j];
+            v[j] = new_vals[i + j];
+        }
+        // 32-bit end-around carry add, then fold into 16 bits together with the old checksum
+        u32x4 s = ~o + v;
+        s -= (u32x4)(s < v);
+        s = fold16_vec((s & 0xffff) + (s >> 16) + (~c & 0xffff));
+        for (size_t j = 0; j < 4; j++)
+            csums[i + j] = static_cast<uint16_t>(~s[j]);
+    }
+    for (; i < n; i++)
+        csums[i] = fastcsum_update32(csums[i], old_vals[i], new_vals[i]);
+}
+
+template <typename T, typename F>
+static void rewrite_batch(
+    uint8_t *const pkts[],
+    size_t n,
+    size_t csum_off,
+    size_t field_off,
+    const T new_vals[],
+    F update) {
+    uint16_t csums[rewrite_chunk];
+    T olds[rewrite_chunk];
+    for (size_t i = 0; i < n; i += rewrite_chunk) {
+        auto todo = n - i < rewrite_chunk ? n - i : rewrite_chunk;
+        for (size_t j = 0; j < todo; j++) {
+            memcpy(&csums[j], pkts[i + j] + csum_off, sizeof(csums[j]));
+            memcpy(&olds[j], pkts[i + j] + field_off, sizeof(olds[j]));
+        }
+        update(csums, olds, &new_vals[i], todo);
+        for (size_t j = 0; j < todo; j++) {
+            memcpy(pkts[i + j] + field_off, &new_vals[i + j], sizeof(new_vals[i + j]));
+            memcpy(pkts[i + j] + csum_off, &csums[j], sizeof(csums[j]));
+        }
+    }
+}
+
+extern "C" void fastcsum_rewrite16_batch(
+    uint8_t *const pkts[],
+    size_t n,
+    size_t csum_off,
+    size_t field_off,
+    const uint16_t new_vals[]) {
+    rewrite_batch(pkts, n, csum_off, field_off, new_vals, fastcsum_update16_batch);
+}
+
+extern "C" void fastcsum_rewrite32_batch(
+    uint8_t *const pkts[],
+    size_t n,
+    size_t csum_off,
+    size_t field_off,
+    const uint32_t new_vals[]) {
+    rewrite_batch(pkts, n, csum_off, field_off, new_vals, fastcsum_update32_batch);
+}
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+#include <sched.h>
+
+#include "bench-util.hpp"
+#include "fastcsum.h"
+
+// Largest buffer a sweep may ask for.
+static constexpr size_t max_size = 64 << 20;
+
+enum class format { table, json, csv };
+
+struct options {
+    std::vector<const fastcsum_kernel *> kernels;
+    std::vector<size_t> sizes;
+    size_t offset = 0;
+    unsigned int repeat = 5;
+    uint64_t min_ticks = 200000;
+    int cpu = -1;
+    format fmt = format::table;
+    const char *output = nullptr;
+};
+
+struct point {
+    const fastcsum_kernel *kernel;
+    size_t size;
+    // best time of one call over the repeats
+    double ticks;
+    double ns;
+};
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "usage: fastcsum-bench [options]\n"
+            "Measures every usable kernel, deprecated ones included, over a sweep of buffer sizes, in TSC cycles per\n"
+            "byte, GB/s and ns per call.\n"
+            "\n"
+            "  -k, --kernel NAME    only run this kernel (repeatable): any fastcsum_nofold_NAME in fastcsum.h,\n"
+            "                       deprecated ones included, or \"nofold\" for the dispatched entry point\n"
+            "  -s, --sizes LIST     comma-separated sizes: N, A-B for every length, A-B:xF for a geometric series\n"
+            "                       (default 1-512,1K-64K:x2)\n"
+            "  -a, --offset N       start the buffer N bytes past a 64-byte boundary (default 0)\n"
+            "  -r, --repeat N       timed samples per point, the fastest one is reported (default 5)\n"
+            "  -m, --min-ticks N    calls per sample are scaled to last at least N TSC ticks (default 200000)\n"
+            "  -c, --cpu N          pin to CPU N\n"
+            "  -f, --format FMT     table (cycles/byte per size and kernel), json or csv\n"
+            "  -o, --output FILE    write to FILE instead of standard output\n"
+            "  -h, --help           show this help\n"
+            "\n"
+            "TSC cycles run at the nominal frequency: they only match core cycles with the CPU frequency pinned\n"
+            "(turbo and frequency scaling disabled).\n");
+}
+
+static bool parse_count(const char *&s, size_t &out) {
+    char *end;
+    errno = 0;
+    auto v = strtoull(s, &end, 10);
+    if (errno || end == s)
+        return false;
+    if (*end == 'K' || *end == 'k') {
+        v <<= 10;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        v <<= 20;
+        end++;
+    }
+    s = end;
+    out = v;
+    return true;
+}
+
+static bool parse_sizes(const char *s, std::vector<size_t> &out) {
+    while (*s) {
+        size_t first, last;
+        if (!parse_count(s, first))
+            return false;
+        last = first;
+        size_t factor = 0;
+        if (*s == '-') {
+            s++;
+            if (!parse_count(s, last))
+                return false;
+            if (*s == ':') {
+                if (*++s != 'x' || !parse_count(++s, factor) || factor < 2)
+                    return false;
+            }
+        }
+        if (!first || last < first || last > max_size)
+            return false;
+        for (size_t n = first; n <= last; n = factor ? n * factor : n + 1)
+            out.push_back(n);
+        if (*s == ',')
+            s++;
+        else if (*s)
+            return false;
+    }
+    return !out.empty();
+}
+
+static std::string cpu_model() {
+    std::string model = "unknown";
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f)
+        return model;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        auto colon = strchr(line, ':');
+        if (strncmp(line, "model name", 10) == 0 && colon) {
+            model = colon + 2;
+            model.erase(model.find_last_not_of("\n ") + 1);
+            break;
+        }
+    }
+    fclose(f);
+    return model;
+}
+
+static std::string json_escape(const std::string &s) {
+    std::string out;
+    for (auto c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            out += c;
+    }
+    return out;
+}
+
+// Times one kernel and size: a calibrated number of back-to-back calls per sample, best sample kept.
+static point measure(const options &opt, const fastcsum_kernel *k, const uint8_t *buf, size_t size, uint64_t &sink) {
+    size_t calls = 1;
+    while (true) {
+        bench_timer t;
+        for (size_t i = 0; i < calls; i++)
+            sink += k->fn(buf, size, 0);
+        t.stop();
+        if (t.ticks() >= opt.min_ticks || calls >= (size_t(1) << 30))
+            break;
+        calls *= t.ticks() * 8 < opt.min_ticks ? 8 : 2;
+    }
+
+    point p = {k, size, 1e30, 0};
+    for (unsigned int r = 0; r < opt.repeat; r++) {
+        bench_timer t;
+        for (size_t i = 0; i < calls; i++)
+            sink += k->fn(buf, size, 0);
+        t.stop();
+        if (static_cast<double>(t.ticks()) / calls < p.ticks) {
+            p.ticks = static_cast<double>(t.ticks()) / calls;
+            p.ns = t.seconds() * 1e9 / calls;
+        }
+    }
+    return p;
+}
+
+static void write_table(FILE *out, const options &opt, const std::vector<point> &points) {
+    fprintf(out, "cycles/byte\n%8s", "size");
+    for (auto k : opt.kernels)
+        fprintf(out, " %*s", static_cast<int>(std::max<size_t>(8, strlen(k->name))), k->name);
+    fprintf(out, "\n");
+    for (size_t i = 0; i < points.size(); i += opt.kernels.size()) {
+        fprintf(out, "%8zu", points[i].size);
+        for (size_t j = 0; j < opt.kernels.size(); j++) {
+            auto &p = points[i + j];
+            fprintf(out, " %*.3f", static_cast<int>(std::max<size_t>(8, strlen(p.kernel->name))), p.ticks / p.size);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+static void write_json(FILE *out, const options &opt, const std::vector<point> &points, double hz) {
+    fprintf(out,
+            "{\n  \"cpu\": \"%s\",\n  \"tsc_hz\": %.0f,\n  \"offset\": %zu,\n  \"results\": [\n",
+            json_escape(cpu_model()).c_str(),
+            hz,
+            opt.offset);
+    for (size_t i = 0; i < points.size(); i++) {
+        auto &p = points[i];
+        fprintf(out,
+                "    {\"kernel\": \"%s\", \"size\": %zu, \"cycles\": %.2f, \"cycles_per_byte\": %.4f, \"ns\": %.2f, "
+                "\"gb_per_s\": %.3f}%s\n",
+                p.kernel->name,
+                p.size,
+                p.ticks,
+                p.ticks / p.size,
+                p.ns,
+                p.size / p.ns,
+                i + 1 < points.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void write_csv(FILE *out, const options &opt, const std::vector<point> &points) {
+    fprintf(out, "kernel,size,offset,cycles,cycles_per_byte,ns,gb_per_s\n");
+    for (auto &p : points)
+        fprintf(out,
+                "%s,%zu,%zu,%.2f,%.4f,%.2f,%.3f\n",
+                p.kernel->name,
+                p.size,
+                opt.offset,
+                p.ticks,
+                p.ticks / p.size,
+                p.ns,
+                p.size / p.ns);
+}
+
+int main(int argc, char **argv) {
+    static const option long_options[] = {
+        {"kernel", required_argument, nullptr, 'k'},
+        {"sizes", required_argument, nullptr, 's'},
+        {"offset", required_argument, nullptr, 'a'},
+        {"repeat", required_argument, nullptr, 'r'},
+        {"min-ticks", required_argument, nullptr, 'm'},
+        {"cpu", required_argument, nullptr, 'c'},
+        {"format", required_argument, nullptr, 'f'},
+        {"output", required_argument, nullptr, 'o'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    options opt;
+    int c;
+    while ((c = getopt_long(argc, argv, "k:s:a:r:m:c:f:o:h", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 'k': {
+            auto k = bench_kernel_find(optarg);
+            if (!k || !k->usable()) {
+                fprintf(stderr, "fastcsum-bench: kernel %s is unknown or not usable\n", optarg);
+                return 2;
+            }
+            opt.kernels.push_back(k);
+            break;
+        }
+        case 's':
+            if (!parse_sizes(optarg, opt.sizes)) {
+                fprintf(stderr, "fastcsum-bench: invalid size list %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'a':
+            opt.offset = strtoull(optarg, nullptr, 10) % bench_pool::line;
+            break;
+        case 'r':
+            opt.repeat = static_cast<unsigned int>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'm':
+            opt.min_ticks = strtoull(optarg, nullptr, 10);
+            break;
+        case 'c':
+            opt.cpu = atoi(optarg);
+            break;
+        case 'f':
+            if (strcmp(optarg, "table") == 0) {
+                opt.fmt = format::table;
+            } else if (strcmp(optarg, "json") == 0) {
+                opt.fmt = format::json;
+            } else if (strcmp(optarg, "csv") == 0) {
+                opt.fmt = format::csv;
+            } else {
+                fprintf(stderr, "fastcsum-bench: unknown format %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'o':
+            opt.output = optarg;
+            break;
+        case 'h':
+            usage(stdout);
+            return 0;
+        default:
+            usage(stderr);
+            return 2;
+        }
+    }
+    if (optind != argc || !opt.repeat) {
+        usage(stderr);
+        return 2;
+    }
+    if (opt.sizes.empty())
+        parse_sizes("1-512,1K-64K:x2", opt.sizes);
+    if (opt.kernels.empty())
+        opt.kernels = bench_usable_kernels();
+    if (opt.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(opt.cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) < 0) {
+            fprintf(stderr, "fastcsum-bench: cannot pin to CPU %d: %s\n", opt.cpu, strerror(errno));
+            return 2;
+        }
+    }
+    double hz = bench_tick_hz();
+    if (!hz) {
+        fprintf(stderr, "fastcsum-bench: no time-stamp counter on this architecture\n");
+        return 2;
+    }
+
+    FILE *out = opt.output ? fopen(opt.output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "fastcsum-bench: %s: %s\n", opt.output, strerror(errno));
+        return 2;
+    }
+
+    // the buffer stays hot in cache: this isolates the kernels, fastcsum-replay covers cold pools and real mixes
+    std::vector<bench_packet> one = {{static_cast<uint32_t>(*std::max_element(opt.sizes.begin(), opt.sizes.end())),
+                                      static_cast<uint32_t>(opt.offset)}};
+    bench_pool pool(one);
+    uint64_t sink = 0;
+    std::vector<point> points;
+    for (auto size : opt.sizes)
+        for (auto k : opt.kernels)
+            points.push_back(measure(opt, k, pool[0], size, sink));
+
+    if (opt.fmt == format::json)
+        write_json(out, opt, points, hz);
+    else if (opt.fmt == format::csv)
+        write_csv(out, opt, points);
+    else
+        write_table(out, opt, points);
+    if (out != stdout && fclose(out) != 0) {
+        fprintf(stderr, "fastcsum-bench: %s: %s\n", opt.output, strerror(errno));
+        return 2;
+    }
+    // keeps the sums from being optimized out
+    return sink == 1 ? 3 : 0;
+}
@@ -0,0 +1,730 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fastcsum.h"
+#include "uring.hpp"
+
+// Below this many bytes per thread, starting threads costs more than it saves.
+static constexpr size_t min_thread_chunk = 1 << 20;
+// Thread chunks start on multiples of this (or of the block size) so that no page is shared between threads.
+static constexpr size_t chunk_align = 1 << 16;
+// O_DIRECT buffer address, length and file offset alignment.
+static constexpr size_t direct_align = 4096;
+
+struct options {
+    const fastcsum_kernel *kernel = nullptr;
+    unsigned int threads = 0;
+    size_t block_size = 0;
+    bool check = false;
+    bool quiet = false;
+    bool direct = false;
+    bool no_uring = false;
+    bool sparse = false;
+    unsigned int depth = 8;
+    size_t buffer_size = 1 << 20;
+};
+
+struct file_result {
+    uint64_t sum = 0;
+    size_t size = 0;
+    // bytes actually read, less than `size` for sparse files in --sparse mode
+    size_t data_bytes = 0;
+    double seconds = 0;
+    unsigned int threads = 1;
+    std::vector<uint16_t> blocks;
+    std::string method = "mmap";
+    // time spent checksumming in streaming modes, summed over threads
+    double csum_seconds = 0;
+};
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "usage: fastcsum-file [options] FILE...\n"
+            "Prints the Internet checksum of each file or block device.\n"
+            "\n"
+            "  -k, --kernel NAME      kernel to use (default: the one picked by fastcsum_nofold)\n"
+            "  -t, --threads N        number of threads (default: one per CPU)\n"
+            "  -b, --block-size SIZE  also print the checksum of every SIZE-byte block (suffixes K, M, G)\n"
+            "  -c, --check            read \"CSUM  FILE\" lines from the FILEs and verify them\n"
+            "  -d, --direct           stream with O_DIRECT reads instead of mmap, for files larger than RAM\n"
+            "      --depth N          reads in flight in --direct mode (default 8)\n"
+            "      --buffer-size SIZE read size in --direct mode, a multiple of 4K (default 1M)\n"
+            "      --no-uring         use a pread thread pool instead of io_uring in --direct mode\n"
+            "  -s, --sparse           only read the data extents of sparse files, as holes sum to zero\n"
+            "  -q, --quiet            do not print throughput to stderr\n"
+            "  -l, --list             list kernels and exit\n"
+            "  -h, --help             show this help\n");
+}
+
+static bool parse_size(const char *s, size_t &out) {
+    char *end;
+    errno = 0;
+    auto v = strtoull(s, &end, 10);
+    if (errno || end == s)
+        return false;
+    switch (*end) {
+    case 'G':
+    case 'g':
+        v <<= 10;
+        // fallthrough
+    case 'M':
+    case 'm':
+        v <<= 10;
+        // fallthrough
+    case 'K':
+    case 'k':
+        v <<= 10;
+        end++;
+        break;
+    }
+    if (*end)
+        return false;
+    out = v;
+    return true;
+}
+
+static const char *kernel_name(const fastcsum_kernel *kernel) {
+    return kernel ? kernel->name : "nofold";
+}
+
+static bool file_size(int fd, size_t &size) {
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+        return false;
+    if (S_ISBLK(st.st_mode)) {
+        uint64_t bytes;
+        if (ioctl(fd, BLKGETSIZE64, &bytes) < 0)
+            return false;
+        size = bytes;
+        return true;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        errno = EINVAL;
+        return false;
+    }
+    size = st.st_size;
+    return true;
+}
+
+struct extent {
+    size_t offset;
+    size_t len;
+};
+
+/*
+ * Lists the allocated extents of the file with SEEK_DATA/SEEK_HOLE, widened to multiples of `align` and merged.
+ * Falls back to the whole file where these are unsupported (e.g. block devices on some kernels).
+ */
+static bool data_extents(int fd, size_t size, size_t align, std::vector<extent> &out) {
+    out.clear();
+    off_t pos = 0;
+    while (static_cast<size_t>(pos) < size) {
+        auto data = lseek(fd, pos, SEEK_DATA);
+        if (data < 0) {
+            if (errno == ENXIO)
+                break;
+            if (errno != EINVAL && errno != EOPNOTSUPP)
+                return false;
+            out.assign(1, {0, size});
+            return true;
+        }
+        auto hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0)
+            return false;
+        auto start = static_cast<size_t>(data) / align * align;
+        auto end = std::min((static_cast<size_t>(hole) + align - 1) / align * align, size);
+        if (!out.empty() && out.back().offset + out.back().len >= start)
+            out.back().len = std::max(out.back().len, end - out.back().offset);
+        else if (end > start)
+            out.push_back({start, end - start});
+        pos = hole;
+    }
+    return true;
+}
+
+// Hands out consecutive pieces of at most `max` bytes of a list of extents. Thread-safe.
+class extent_cursor {
+public:
+    extent_cursor(const std::vector<extent> &extents_, size_t max_) : extents(extents_), max(max_) {
+    }
+
+    bool next(extent &out) {
+        std::lock_guard<std::mutex> guard(lock);
+        while (idx < extents.size() && pos >= extents[idx].len) {
+            idx++;
+            pos = 0;
+        }
+        if (idx == extents.size())
+            return false;
+        out = {extents[idx].offset + pos, std::min(max, extents[idx].len - pos)};
+        pos += out.len;
+        return true;
+    }
+
+private:
+    const std::vector<extent> &extents;
+    size_t max;
+    std::mutex lock;
+    size_t idx = 0;
+    size_t pos = 0;
+};
+
+// Sums `size` mapped bytes on several threads, filling in per-block checksums if requested.
+static uint64_t sum_mapped(const uint8_t *ptr, size_t size, const options &opt, file_result &res) {
+    auto fn = opt.kernel->fn;
+    auto align = opt.block_size ? opt.block_size : chunk_align;
+    unsigned int nthreads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    nthreads = static_cast<unsigned int>(std::min<size_t>(nthreads, std::max<size_t>(1, size / min_thread_chunk)));
+    nthreads = static_cast<unsigned int>(std::min<size_t>(nthreads, (size + align - 1) / align));
+    nthreads = std::max(1u, nthreads);
+    res.threads = nthreads;
+    if (opt.block_size)
+        res.blocks.resize((size + opt.block_size - 1) / opt.block_size);
+
+    std::vector<size_t> offsets(nthreads + 1);
+    for (unsigned int i = 0; i < nthreads; i++)
+        offsets[i] = size / nthreads * i / align * align;
+    offsets[nthreads] = size;
+
+    std::vector<uint64_t> sums(nthreads);
+    auto work = [&](unsigned int i) {
+        auto start = offsets[i], end = offsets[i + 1];
+        if (!opt.block_size) {
+            sums[i] = fn(ptr + start, end - start, 0);
+            return;
+        }
+        // the chunk total is assembled from the block sums, so the data is read once
+        uint64_t ac = 0;
+        for (auto off = start; off < end; off += opt.block_size) {
+            auto todo = std::min(opt.block_size, end - off);
+            auto s = fn(ptr + off, todo, 0);
+            res.blocks[off / opt.block_size] = fastcsum_fold_complement(s);
+            ac = fastcsum_combine(ac, s, off - start);
+        }
+        sums[i] = ac;
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nthreads; i++)
+        threads.emplace_back(work, i);
+    work(0);
+    for (auto &t : threads)
+        t.join();
+
+    uint64_t ac = 0;
+    for (unsigned int i = 0; i < nthreads; i++)
+        ac = fastcsum_combine(ac, sums[i], offsets[i]);
+    return ac;
+}
+
+// Accumulates buffers that complete in any order into the file sum and the block sums. Thread-safe.
+class stream_sum {
+public:
+    stream_sum(const options &opt_, size_t size) : opt(opt_) {
+        if (opt.block_size)
+            block_sums.resize((size + opt.block_size - 1) / opt.block_size);
+    }
+
+    void add(size_t offset, const uint8_t *data, size_t len) {
+        struct piece {
+            size_t offset;
+            uint64_t sum;
+        };
+        std::vector<piece> pieces;
+        auto start = std::chrono::steady_clock::now();
+        if (!opt.block_size) {
+            pieces.push_back({offset, opt.kernel->fn(data, len, 0)});
+        } else {
+            // blocks may straddle buffers, so each piece is added to its block at its offset within the block
+            for (auto pos = offset; pos < offset + len;) {
+                auto end = std::min((pos / opt.block_size + 1) * opt.block_size, offset + len);
+                pieces.push_back({pos, opt.kernel->fn(data + (pos - offset), end - pos, 0)});
+                pos = end;
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto &p : pieces) {
+            total = fastcsum_combine(total, p.sum, p.offset);
+            if (opt.block_size) {
+                auto b = p.offset / opt.block_size;
+                block_sums[b] = fastcsum_combine(block_sums[b], p.sum, p.offset - b * opt.block_size);
+            }
+        }
+        csum_seconds += elapsed;
+    }
+
+    void finish(file_result &res) {
+        res.sum = total;
+        res.csum_seconds = csum_seconds;
+        res.blocks.resize(block_sums.size());
+        for (size_t i = 0; i < block_sums.size(); i++)
+            res.blocks[i] = fastcsum_fold_complement(block_sums[i]);
+    }
+
+private:
+    const options &opt;
+    std::mutex lock;
+    uint64_t total = 0;
+    std::vector<uint64_t> block_sums;
+    double csum_seconds = 0;
+};
+
+struct aligned_buffer {
+    explicit aligned_buffer(size_t size) : ptr(static_cast<uint8_t *>(aligned_alloc(direct_align, size))) {
+    }
+    ~aligned_buffer() {
+        free(ptr);
+    }
+    aligned_buffer(const aligned_buffer &) = delete;
+    aligned_buffer &operator=(const aligned_buffer &) = delete;
+    aligned_buffer(aligned_buffer &&other) : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    uint8_t *ptr;
+};
+
+// One read buffer of `stream_uring`, with the iovec the kernel reads it through.
+struct uring_slot {
+    aligned_buffer buf;
+    iovec iov;
+    extent piece;
+    size_t done;
+};
+
+/*
+ * Keeps `depth` reads in flight and checksums each buffer as soon as it completes, while the others are pending.
+ * `slots` is owned by the caller and must outlive `ring`, as reads still in flight when this fails complete into it.
+ */
+static bool stream_uring(
+    uring &ring,
+    std::vector<uring_slot> &slots,
+    int fd,
+    extent_cursor &cursor,
+    const options &opt,
+    stream_sum &acc) {
+    for (unsigned int i = 0; i < opt.depth; i++) {
+        slots.push_back({aligned_buffer(opt.buffer_size), {}, {}, 0});
+        if (!slots.back().buf.ptr)
+            return false;
+    }
+
+    // after an error, no more reads are issued but those in flight are still reaped
+    unsigned int inflight = 0;
+    int error = 0;
+    auto issue = [&](unsigned int i) {
+        auto &sl = slots[i];
+        // the tail of the file is read up to the next aligned length, which O_DIRECT requires
+        auto len = (sl.piece.len + direct_align - 1) / direct_align * direct_align;
+        sl.iov = {sl.buf.ptr + sl.done, len - sl.done};
+        // the ring has an entry per slot, so this only fails if that invariant breaks
+        if (ring.queue_readv(fd, &sl.iov, 1, sl.piece.offset + sl.done, i))
+            inflight++;
+        else if (!error)
+            error = EBUSY;
+    };
+    for (unsigned int i = 0; i < opt.depth && !error && cursor.next(slots[i].piece); i++)
+        issue(i);
+
+    while (inflight) {
+        if (!ring.submit(1))
+            return false;
+        io_uring_cqe cqe;
+        while (ring.pop(cqe)) {
+            inflight--;
+            auto i = static_cast<unsigned int>(cqe.user_data);
+            auto &sl = slots[i];
+            if (error)
+                continue;
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                issue(i);
+                continue;
+            }
+            if (cqe.res < 0) {
+                error = -cqe.res;
+                continue;
+            }
+            sl.done += cqe.res;
+            if (sl.done < sl.piece.len) {
+                if (!cqe.res) {
+                    // the file shrank while being read
+                    error = EIO;
+                    continue;
+                }
+                issue(i);
+                continue;
+            }
+
+            acc.add(sl.piece.offset, sl.buf.ptr, sl.piece.len);
+            sl.done = 0;
+            if (cursor.next(sl.piece))
+                issue(i);
+        }
+    }
+    errno = error;
+    return !error;
+}
+
+// Fallback for kernels without io_uring: `depth` threads each alternate between a blocking read and checksumming.
+static bool stream_pread(int fd, extent_cursor &cursor, const options &opt, stream_sum &acc) {
+    std::atomic<int> error(0);
+    auto work = [&]() {
+        aligned_buffer buf(opt.buffer_size);
+        if (!buf.ptr) {
+            error = ENOMEM;
+            return;
+        }
+        extent piece;
+        while (!error && cursor.next(piece)) {
+            auto len = (piece.len + direct_align - 1) / direct_align * direct_align;
+            size_t done = 0;
+            while (done < piece.len) {
+                auto ret = pread(fd, buf.ptr + done, len - done, piece.offset + done);
+                if (ret < 0 && errno == EINTR)
+                    continue;
+                if (ret <= 0) {
+                    error = ret < 0 ? errno : EIO;
+                    return;
+                }
+                done += ret;
+            }
+            acc.add(piece.offset, buf.ptr, piece.len);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < opt.depth; i++)
+        threads.emplace_back(work);
+    work();
+    for (auto &t : threads)
+        t.join();
+    if (error)
+        errno = error;
+    return !error;
+}
+
+// Sums the given extents of a mapped file on several threads; holes are never touched.
+static void sum_mapped_extents(
+    const uint8_t *ptr,
+    const std::vector<extent> &extents,
+    const options &opt,
+    file_result &res) {
+    size_t data = 0;
+    for (auto &e : extents)
+        data += e.len;
+    unsigned int nthreads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    nthreads = static_cast<unsigned int>(std::min<size_t>(nthreads, std::max<size_t>(1, data / min_thread_chunk)));
+    res.threads = nthreads;
+
+    extent_cursor cursor(extents, min_thread_chunk);
+    stream_sum acc(opt, res.size);
+    auto work = [&]() {
+        extent piece;
+        while (cursor.next(piece))
+            acc.add(piece.offset, ptr + piece.offset, piece.len);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nthreads; i++)
+        threads.emplace_back(work);
+    work();
+    for (auto &t : threads)
+        t.join();
+    acc.finish(res);
+}
+
+static bool checksum_stream(const char *path, const options &opt, file_result &res) {
+    int fd = open(path, O_RDONLY | O_DIRECT);
+    bool buffered = false;
+    if (fd < 0 && errno == EINVAL) {
+        // e.g. tmpfs, which has no O_DIRECT support
+        fd = open(path, O_RDONLY);
+        buffered = true;
+    }
+    if (fd < 0)
+        return false;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = file_size(fd, res.size);
+    std::vector<extent> extents(1, {0, res.size});
+    if (ok && opt.sparse)
+        ok = data_extents(fd, res.size, direct_align, extents);
+    if (ok) {
+        for (auto &e : extents)
+            res.data_bytes += e.len;
+        extent_cursor cursor(extents, opt.buffer_size);
+        stream_sum acc(opt, res.size);
+        // declared before the ring so that the buffers outlive it
+        std::vector<uring_slot> slots;
+        uring ring;
+        if (!opt.no_uring && ring.init(opt.depth)) {
+            res.method = "io_uring";
+            ok = stream_uring(ring, slots, fd, cursor, opt, acc);
+        } else {
+            res.method = "pread";
+            ok = stream_pread(fd, cursor, opt, acc);
+        }
+        if (buffered)
+            res.method += " (buffered)";
+        res.threads = res.method == "io_uring" ? 1 : opt.depth;
+        acc.finish(res);
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto saved = errno;
+    close(fd);
+    errno = saved;
+    return ok;
+}
+
+static bool checksum_file(const char *path, const options &opt, file_result &res) {
+    if (opt.direct)
+        return checksum_stream(path, opt, res);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = file_size(fd, res.size);
+    std::vector<extent> extents(1, {0, res.size});
+    if (ok && opt.sparse)
+        ok = data_extents(fd, res.size, 1, extents);
+    if (ok && res.size) {
+        auto ptr = mmap(nullptr, res.size, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ok = false;
+        } else {
+            // both are hints; MADV_HUGEPAGE only has an effect on file systems that support it
+            madvise(ptr, res.size, MADV_SEQUENTIAL);
+            madvise(ptr, res.size, MADV_HUGEPAGE);
+            for (auto &e : extents)
+                res.data_bytes += e.len;
+            if (opt.sparse)
+                sum_mapped_extents(static_cast<const uint8_t *>(ptr), extents, opt, res);
+            else
+                res.sum = sum_mapped(static_cast<const uint8_t *>(ptr), res.size, opt, res);
+            munmap(ptr, res.size);
+        }
+    }
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto saved = errno;
+    close(fd);
+    errno = saved;
+    return ok;
+}
+
+static void print_stats(const char *path, const options &opt, const file_result &res) {
+    if (opt.quiet)
+        return;
+    fprintf(stderr,
+            "%s: %zu bytes in %.3f s, %.2f GB/s, kernel %s, %s, %u threads\n",
+            path,
+            res.size,
+            res.seconds,
+            res.seconds > 0 ? res.size / res.seconds / 1e9 : 0.0,
+            kernel_name(opt.kernel),
+            res.method.c_str(),
+            res.threads);
+    if (res.data_bytes < res.size)
+        fprintf(stderr,
+                "%s: read %zu bytes of data, skipped %zu bytes of holes\n",
+                path,
+                res.data_bytes,
+                res.size - res.data_bytes);
+    // in streaming modes the wall-clock rate is the device bandwidth; compare it with what checksumming alone achieves
+    if (res.csum_seconds > 0)
+        fprintf(stderr,
+                "%s: checksum %.2f GB/s per thread, %.0f%% of wall time\n",
+                path,
+                res.data_bytes / res.csum_seconds / 1e9,
+                100 * res.csum_seconds / res.threads / res.seconds);
+}
+
+static int run_sum(const char *path, const options &opt) {
+    file_result res;
+    if (!checksum_file(path, opt, res)) {
+        fprintf(stderr, "fastcsum-file: %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    for (size_t i = 0; i < res.blocks.size(); i++)
+        printf("%04x  %s@%zu\n", res.blocks[i], path, i * opt.block_size);
+    printf("%04x  %s\n", fastcsum_fold_complement(res.sum), path);
+    print_stats(path, opt, res);
+    return 0;
+}
+
+/*
+ * Per-block lines name "PATH@OFFSET". A name with a trailing "@<digits>" is only taken for one when no such file
+ * exists and PATH does, so files with '@' in their names are still checked and a missing one is still reported.
+ */
+static bool is_block_line(const char *path) {
+    auto at = strrchr(path, '@');
+    if (!at || !at[1] || strspn(at + 1, "0123456789") != strlen(at + 1))
+        return false;
+    struct stat st;
+    return stat(path, &st) < 0 && stat(std::string(path, at).c_str(), &st) == 0;
+}
+
+// Verifies a list in the output format of this tool, skipping per-block lines.
+static int run_check(const char *list, const options &opt) {
+    FILE *f = fopen(list, "r");
+    if (!f) {
+        fprintf(stderr, "fastcsum-file: %s: %s\n", list, strerror(errno));
+        return 1;
+    }
+    int ret = 0;
+    char *line = nullptr;
+    size_t cap = 0;
+    ssize_t len;
+    options check_opt = opt;
+    check_opt.block_size = 0;
+    while ((len = getline(&line, &cap, f)) > 0) {
+        if (line[len - 1] == '\n')
+            line[--len] = 0;
+        unsigned int expected;
+        int pos = 0;
+        if (sscanf(line, "%4x  %n", &expected, &pos) != 1 || !pos) {
+            fprintf(stderr, "fastcsum-file: %s: malformed line: %s\n", list, line);
+            ret = 1;
+            continue;
+        }
+        auto path = line + pos;
+        if (is_block_line(path))
+            continue;
+        file_result res;
+        if (!checksum_file(path, check_opt, res)) {
+            printf("%s: FAILED open or read: %s\n", path, strerror(errno));
+            ret = 1;
+            continue;
+        }
+        bool match = fastcsum_fold_complement(res.sum) == expected;
+        printf("%s: %s\n", path, match ? "OK" : "FAILED");
+        if (!match)
+            ret = 1;
+        print_stats(path, check_opt, res);
+    }
+    free(line);
+    fclose(f);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    static const option long_options[] = {
+        {"kernel", required_argument, nullptr, 'k'},
+        {"threads", required_argument, nullptr, 't'},
+        {"block-size", required_argument, nullptr, 'b'},
+        {"check", no_argument, nullptr, 'c'},
+        {"direct", no_argument, nullptr, 'd'},
+        {"depth", required_argument, nullptr, 'D'},
+        {"buffer-size", required_argument, nullptr, 'B'},
+        {"no-uring", no_argument, nullptr, 'U'},
+        {"sparse", no_argument, nullptr, 's'},
+        {"quiet", no_argument, nullptr, 'q'},
+        {"list", no_argument, nullptr, 'l'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    options opt;
+    size_t nkernels;
+    auto kernels = fastcsum_kernels(&nkernels);
+    int c;
+    while ((c = getopt_long(argc, argv, "k:t:b:cdsqlh", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 'k':
+            opt.kernel = fastcsum_kernel_find(optarg);
+            if (!opt.kernel) {
+                fprintf(stderr, "fastcsum-file: unknown kernel %s (see --list)\n", optarg);
+                return 2;
+            }
+            if (!opt.kernel->usable()) {
+                fprintf(stderr, "fastcsum-file: kernel %s is not usable on this CPU or build\n", optarg);
+                return 2;
+            }
+            break;
+        case 't':
+            opt.threads = static_cast<unsigned int>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'b':
+            if (!parse_size(optarg, opt.block_size) || !opt.block_size) {
+                fprintf(stderr, "fastcsum-file: invalid block size %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'c':
+            opt.check = true;
+            break;
+        case 'd':
+            opt.direct = true;
+            break;
+        case 'D':
+            opt.depth = static_cast<unsigned int>(strtoul(optarg, nullptr, 10));
+            if (!opt.depth || opt.depth > 4096) {
+                fprintf(stderr, "fastcsum-file: invalid depth %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'B':
+            if (!parse_size(optarg, opt.buffer_size) || !opt.buffer_size || opt.buffer_size % direct_align ||
+                opt.buffer_size > UINT32_MAX) {
+                fprintf(stderr, "fastcsum-file: invalid buffer size %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'U':
+            opt.no_uring = true;
+            break;
+        case 's':
+            opt.sparse = true;
+            break;
+        case 'q':
+            opt.quiet = true;
+            break;
+        case 'l':
+            for (size_t i = 0; i < nkernels; i++)
+                printf("%-16s%s\n", kernels[i].name, kernels[i].usable() ? "" : " (not usable)");
+            return 0;
+        case 'h':
+            usage(stdout);
+            return 0;
+        default:
+            usage(stderr);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(stderr);
+        return 2;
+    }
+
+    if (!opt.kernel) {
+        auto best = fastcsum_nofold_best();
+        for (size_t i = 0; i < nkernels && !opt.kernel; i++)
+            if (kernels[i].fn == best)
+                opt.kernel = &kernels[i];
+    }
+    static const fastcsum_kernel nofold = {"nofold", fastcsum_nofold, nullptr};
+    if (!opt.kernel)
+        opt.kernel = &nofold;
+
+    int ret = 0;
+    for (int i = optind; i < argc; i++)
+        ret |= opt.check ? run_check(argv[i], opt) : run_sum(argv[i], opt);
+    return ret;
+}
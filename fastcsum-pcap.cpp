@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fastcsum-net.h"
+#include "pcap.hpp"
+
+// Frames per unit of work handed to a thread, few enough that they are still cached when the thread processes them.
+static constexpr size_t chunk_frames = 512;
+// Frames per `fastcsum_frame_verify_batch` call.
+static constexpr size_t batch_frames = 64;
+// Below this many bytes of capture per thread, starting threads costs more than it saves.
+static constexpr size_t min_thread_bytes = 1 << 20;
+
+struct options {
+    unsigned int threads = 0;
+    const char *output = nullptr;
+    bool quiet = false;
+};
+
+struct counters {
+    size_t frames = 0;
+    size_t bytes = 0;
+    size_t ipv4 = 0;
+    size_t ipv6 = 0;
+    size_t tcp = 0;
+    size_t udp = 0;
+    size_t udplite = 0;
+    size_t icmp = 0;
+    size_t bad_ipv4 = 0;
+    size_t bad_tcp = 0;
+    size_t bad_udp = 0;
+    size_t bad_udplite = 0;
+    size_t bad_icmp = 0;
+    size_t fragments = 0;
+    size_t no_udp_csum = 0;
+    size_t malformed = 0;
+    size_t truncated = 0;
+    size_t not_ethernet = 0;
+    size_t fixed = 0;
+
+    void tally(unsigned int flags) {
+        bool bad_l4 = flags & FASTCSUM_FRAME_BAD_L4;
+        ipv4 += !!(flags & FASTCSUM_FRAME_IPV4);
+        ipv6 += !!(flags & FASTCSUM_FRAME_IPV6);
+        bad_ipv4 += !!(flags & FASTCSUM_FRAME_BAD_L3);
+        if (flags & FASTCSUM_FRAME_TCP) {
+            tcp++;
+            bad_tcp += bad_l4;
+        } else if (flags & FASTCSUM_FRAME_UDP) {
+            udp++;
+            bad_udp += bad_l4;
+        } else if (flags & FASTCSUM_FRAME_UDPLITE) {
+            udplite++;
+            bad_udplite += bad_l4;
+        } else if (flags & FASTCSUM_FRAME_ICMP) {
+            icmp++;
+            bad_icmp += bad_l4;
+        }
+        fragments += !!(flags & FASTCSUM_FRAME_FRAGMENT);
+        no_udp_csum += !!(flags & FASTCSUM_FRAME_NO_L4_CSUM);
+        malformed += !!(flags & FASTCSUM_FRAME_MALFORMED);
+    }
+
+    counters &operator+=(const counters &o) {
+        frames += o.frames;
+        bytes += o.bytes;
+        ipv4 += o.ipv4;
+        ipv6 += o.ipv6;
+        tcp += o.tcp;
+        udp += o.udp;
+        udplite += o.udplite;
+        icmp += o.icmp;
+        bad_ipv4 += o.bad_ipv4;
+        bad_tcp += o.bad_tcp;
+        bad_udp += o.bad_udp;
+        bad_udplite += o.bad_udplite;
+        bad_icmp += o.bad_icmp;
+        fragments += o.fragments;
+        no_udp_csum += o.no_udp_csum;
+        malformed += o.malformed;
+        truncated += o.truncated;
+        not_ethernet += o.not_ethernet;
+        fixed += o.fixed;
+        return *this;
+    }
+
+    size_t errors() const {
+        return bad_ipv4 + bad_tcp + bad_udp + bad_udplite + bad_icmp;
+    }
+};
+
+struct chunk {
+    pcap_reader reader;
+    size_t nframes;
+};
+
+// Hands out consecutive chunks of a capture. Record headers must be walked to find chunk boundaries; whichever thread
+// claims a chunk walks it, so this work is spread across threads and leaves the frames cached for processing.
+class chunk_cursor {
+public:
+    explicit chunk_cursor(const pcap_reader &reader_) : reader(reader_) {
+    }
+
+    bool next(chunk &c) {
+        std::lock_guard<std::mutex> guard(lock);
+        c = {reader, 0};
+        pcap_frame f;
+        while (c.nframes < chunk_frames && reader.next(f))
+            c.nframes++;
+        return c.nframes;
+    }
+
+    bool damaged() {
+        std::lock_guard<std::mutex> guard(lock);
+        return reader.damaged();
+    }
+
+private:
+    std::mutex lock;
+    pcap_reader reader;
+};
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "usage: fastcsum-pcap [options] CAPTURE...\n"
+            "Verifies the IPv4, TCP, UDP, UDP-Lite, ICMP and ICMPv6 checksums of Ethernet frames in pcap and pcapng\n"
+            "captures. Exits with status 1 if any checksum is bad.\n"
+            "\n"
+            "  -w, --write OUT    write a copy of the capture with bad checksums fixed to OUT (one capture only)\n"
+            "  -t, --threads N    number of threads (default: one per CPU)\n"
+            "  -q, --quiet        only print the summary line\n"
+            "  -h, --help         show this help\n");
+}
+
+// Verifies the frames of one chunk in batches; with `fix`, recomputes the checksums of frames that fail.
+static void process_chunk(chunk &c, bool fix, counters &cnt) {
+    uint8_t *ptrs[batch_frames];
+    size_t lens[batch_frames];
+    unsigned int flags[batch_frames];
+    size_t n = 0;
+    auto flush = [&]() {
+        fastcsum_frame_verify_batch(ptrs, lens, n, flags, nullptr);
+        for (size_t i = 0; i < n; i++) {
+            cnt.tally(flags[i]);
+            if (fix && (flags[i] & (FASTCSUM_FRAME_BAD_L3 | FASTCSUM_FRAME_BAD_L4))) {
+                fastcsum_frame_fill(ptrs[i], lens[i], nullptr);
+                cnt.fixed++;
+            }
+        }
+        n = 0;
+    };
+
+    pcap_frame f;
+    for (size_t i = 0; i < c.nframes && c.reader.next(f); i++) {
+        cnt.frames++;
+        cnt.bytes += f.caplen;
+        if (f.linktype != LINKTYPE_ETHERNET) {
+            cnt.not_ethernet++;
+            continue;
+        }
+        // L4 checksums of frames cut at the snapshot length cannot be checked
+        if (f.caplen < f.origlen) {
+            cnt.truncated++;
+            continue;
+        }
+        ptrs[n] = f.data;
+        lens[n] = f.caplen;
+        if (++n == batch_frames)
+            flush();
+    }
+    flush();
+}
+
+static bool copy_file(const char *from, const char *to) {
+    int in = open(from, O_RDONLY);
+    if (in < 0)
+        return false;
+    int out = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+    bool ok = true;
+    std::vector<char> buf(1 << 20);
+    while (true) {
+        auto got = read(in, buf.data(), buf.size());
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0) {
+            ok = !got;
+            break;
+        }
+        for (ssize_t done = 0; done < got;) {
+            auto ret = write(out, buf.data() + done, got - done);
+            if (ret < 0 && errno == EINTR)
+                continue;
+            if (ret < 0) {
+                ok = false;
+                break;
+            }
+            done += ret;
+        }
+        if (!ok)
+            break;
+    }
+    auto saved = errno;
+    close(in);
+    if (close(out) < 0)
+        ok = false;
+    else
+        errno = saved;
+    return ok;
+}
+
+static void print_report(const char *path, const counters &c) {
+    printf("%s:\n", path);
+    printf("  %-14s %12s %12s\n", "", "frames", "bad csum");
+    printf("  %-14s %12zu %12zu\n", "ipv4", c.ipv4, c.bad_ipv4);
+    printf("  %-14s %12zu %12s\n", "ipv6", c.ipv6, "-");
+    printf("  %-14s %12zu %12zu\n", "tcp", c.tcp, c.bad_tcp);
+    printf("  %-14s %12zu %12zu\n", "udp", c.udp, c.bad_udp);
+    printf("  %-14s %12zu %12zu\n", "udplite", c.udplite, c.bad_udplite);
+    printf("  %-14s %12zu %12zu\n", "icmp", c.icmp, c.bad_icmp);
+    printf("  %-14s %12zu\n", "fragments", c.fragments);
+    printf("  %-14s %12zu\n", "no udp csum", c.no_udp_csum);
+    printf("  %-14s %12zu\n", "malformed", c.malformed);
+    printf("  %-14s %12zu\n", "truncated", c.truncated);
+    printf("  %-14s %12zu\n", "not ethernet", c.not_ethernet);
+    if (c.fixed)
+        printf("  %-14s %12zu\n", "fixed", c.fixed);
+}
+
+static int run(const char *path, const options &opt) {
+    const char *target = path;
+    if (opt.output) {
+        if (!copy_file(path, opt.output)) {
+            fprintf(stderr, "fastcsum-pcap: %s: %s\n", opt.output, strerror(errno));
+            return 2;
+        }
+        target = opt.output;
+    }
+    bool fix = opt.output != nullptr;
+
+    int fd = open(target, fix ? O_RDWR : O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        fprintf(stderr, "fastcsum-pcap: %s: %s\n", target, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return 2;
+    }
+    size_t size = st.st_size;
+    void *map = size ? mmap(nullptr, size, fix ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "fastcsum-pcap: %s: %s\n", target, strerror(errno));
+        return 2;
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    madvise(map, size, MADV_HUGEPAGE);
+
+    auto start = std::chrono::steady_clock::now();
+    pcap_reader reader;
+    if (!reader.open(static_cast<uint8_t *>(map), size)) {
+        fprintf(stderr, "fastcsum-pcap: %s: not a pcap or pcapng capture\n", path);
+        if (map)
+            munmap(map, size);
+        return 2;
+    }
+
+    unsigned int nthreads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    nthreads = static_cast<unsigned int>(std::min<size_t>(nthreads, size / min_thread_bytes + 1));
+    std::vector<counters> per_thread(nthreads);
+    chunk_cursor cursor(reader);
+    auto work = [&](unsigned int t) {
+        chunk c;
+        while (cursor.next(c))
+            process_chunk(c, fix, per_thread[t]);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nthreads; i++)
+        threads.emplace_back(work, i);
+    work(0);
+    for (auto &t : threads)
+        t.join();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (map)
+        munmap(map, size);
+
+    counters total;
+    for (auto &c : per_thread)
+        total += c;
+    if (!opt.quiet)
+        print_report(path, total);
+    printf("%s: %zu frames, %zu bytes in %.3f s, %.2f Mpps, %.2f GB/s, %u threads, %zu bad checksums%s\n",
+           path,
+           total.frames,
+           total.bytes,
+           seconds,
+           seconds > 0 ? total.frames / seconds / 1e6 : 0.0,
+           seconds > 0 ? total.bytes / seconds / 1e9 : 0.0,
+           nthreads,
+           total.errors(),
+           fix ? " (fixed)" : "");
+    bool damaged = cursor.damaged();
+    if (damaged)
+        fprintf(stderr, "fastcsum-pcap: %s: stopped at a damaged record\n", path);
+    return damaged ? 2 : (!fix && total.errors()) ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    static const option long_options[] = {
+        {"write", required_argument, nullptr, 'w'},
+        {"threads", required_argument, nullptr, 't'},
+        {"quiet", no_argument, nullptr, 'q'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    options opt;
+    int c;
+    while ((c = getopt_long(argc, argv, "w:t:qh", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 'w':
+            opt.output = optarg;
+            break;
+        case 't':
+            opt.threads = static_cast<unsigned int>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'q':
+            opt.quiet = true;
+            break;
+        case 'h':
+            usage(stdout);
+            return 0;
+        default:
+            usage(stderr);
+            return 2;
+        }
+    }
+    if (optind >= argc || (opt.output && argc - optind != 1)) {
+        usage(stderr);
+        return 2;
+    }
+
+    int ret = 0;
+    for (int i = optind; i < argc; i++)
+        ret = std::max(ret, run(argv[i], opt));
+    return ret;
+}
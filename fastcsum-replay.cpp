@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench-util.hpp"
+#include "fastcsum-net.h"
+#include "pcap.hpp"
+
+// Histogram offsets must stay below this: a packet's slot in the pool is offset + size bytes.
+static constexpr unsigned long max_offset = 4096;
+
+struct options {
+    const char *pcap = nullptr;
+    const char *hist = nullptr;
+    const char *mix = nullptr;
+    bool misalign = false;
+    std::vector<const fastcsum_kernel *> kernels;
+    size_t packets = 65536;
+    unsigned int rounds = 5;
+};
+
+struct mix_size {
+    uint32_t size;
+    unsigned int weight;
+};
+
+// Standard synthetic packet size mixes, by IP packet or frame size as usually quoted.
+struct mix {
+    const char *name;
+    const char *description;
+    std::vector<mix_size> sizes;
+};
+
+static const mix mixes[] = {
+    {"simple", "simple IMIX, 7:4:1 of 64/576/1500", {{64, 7}, {576, 4}, {1500, 1}}},
+    {"tolly", "Tolly Internet IMIX, 55:5:17:23 of 64/78/576/1518", {{64, 55}, {78, 5}, {576, 17}, {1518, 23}}},
+    {"jumbo", "simple IMIX with jumbo frames, 7:4:1 of 64/1500/9000", {{64, 7}, {1500, 4}, {9000, 1}}},
+    {"random", "uniform random sizes 1-9000 at random offsets 0-63", {}},
+};
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "usage: fastcsum-replay [options] (--pcap FILE | --hist FILE | --mix NAME)\n"
+            "Replays a packet size and offset distribution against every usable kernel, deprecated ones included.\n"
+            "\n"
+            "  -p, --pcap FILE      replay the L4 segment sizes and offsets of a pcap/pcapng capture\n"
+            "  -H, --hist FILE      replay \"SIZE COUNT\" or \"SIZE OFFSET COUNT\" lines ('#' comments)\n"
+            "  -m, --mix NAME       replay a synthetic mix (--mix list shows them)\n"
+            "  -a, --misalign       start packets at random offsets 0-63 instead of their recorded ones\n"
+            "  -k, --kernel NAME    only run this kernel (repeatable): any fastcsum_nofold_NAME in fastcsum.h,\n"
+            "                       deprecated ones included, or \"nofold\" for the dispatched entry point\n"
+            "  -n, --packets N      packets replayed, each in its own buffer of the pool (default 65536)\n"
+            "  -r, --rounds N       timed passes per kernel, the best one is reported (default 5)\n"
+            "  -h, --help           show this help\n");
+}
+
+// Takes the L4 segment of each Ethernet frame, or the whole frame where there is none.
+static bool load_pcap(const char *path, std::vector<bench_packet> &out) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        fprintf(stderr, "fastcsum-replay: %s: %s\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void *map = size ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : nullptr;
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "fastcsum-replay: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    pcap_reader reader;
+    bool ok = reader.open(static_cast<uint8_t *>(map), size);
+    if (!ok)
+        fprintf(stderr, "fastcsum-replay: %s: not a pcap or pcapng capture\n", path);
+    pcap_frame f;
+    while (ok && reader.next(f)) {
+        bench_packet s = {static_cast<uint32_t>(f.caplen), 0};
+        fastcsum_frame_info info;
+        if (f.linktype == LINKTYPE_ETHERNET &&
+            !(fastcsum_frame_verify(f.data, f.caplen, &info) & FASTCSUM_FRAME_MALFORMED) && info.l4_offset) {
+            s.offset = static_cast<uint32_t>(info.l4_offset);
+            s.size = static_cast<uint32_t>(std::min(info.l4_len, f.caplen - info.l4_offset));
+        }
+        if (s.size)
+            out.push_back(s);
+    }
+    if (map)
+        munmap(map, size);
+    return ok;
+}
+
+static bool load_hist(const char *path, std::vector<bench_packet> &out, std::vector<size_t> &counts) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "fastcsum-replay: %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    bool ok = true;
+    char *line = nullptr;
+    size_t cap = 0;
+    size_t total = 0;
+    for (unsigned int lineno = 1; getline(&line, &cap, f) > 0; lineno++) {
+        if (auto hash = strchr(line, '#'))
+            *hash = 0;
+        unsigned long a, b, c;
+        int n = sscanf(line, "%lu %lu %lu", &a, &b, &c);
+        if (n <= 0)
+            continue;
+        if (n == 1 || !a || a > UINT32_MAX) {
+            fprintf(stderr, "fastcsum-replay: %s:%u: expected SIZE [OFFSET] COUNT\n", path, lineno);
+            ok = false;
+            break;
+        }
+        if (n == 3 && b >= max_offset) {
+            fprintf(stderr, "fastcsum-replay: %s:%u: offset %lu is not below %lu\n", path, lineno, b, max_offset);
+            ok = false;
+            break;
+        }
+        out.push_back({static_cast<uint32_t>(a), n == 3 ? static_cast<uint32_t>(b) : 0});
+        counts.push_back(n == 3 ? c : b);
+        total += counts.back();
+    }
+    free(line);
+    fclose(f);
+    // the packets are drawn with these counts as weights, which must not all be zero
+    if (ok && !out.empty() && !total) {
+        fprintf(stderr, "fastcsum-replay: %s: all counts are zero\n", path);
+        ok = false;
+    }
+    return ok;
+}
+
+// Draws `n` packets from weighted samples, in a random order fixed by the seed.
+static std::vector<bench_packet>
+draw(const std::vector<bench_packet> &samples, const std::vector<size_t> &counts, size_t n) {
+    std::mt19937_64 rnd(1);
+    std::discrete_distribution<size_t> pick(counts.begin(), counts.end());
+    std::vector<bench_packet> out(n);
+    for (auto &s : out)
+        s = samples[pick(rnd)];
+    return out;
+}
+
+static void list_mixes() {
+    for (auto &m : mixes)
+        printf("%-8s %s\n", m.name, m.description);
+}
+
+static bool load_mix(const char *name, std::vector<bench_packet> &out, std::vector<size_t> &counts, bool &misalign) {
+    for (auto &m : mixes) {
+        if (strcmp(m.name, name) != 0)
+            continue;
+        if (m.sizes.empty()) {
+            for (uint32_t size = 1; size <= 9000; size++)
+                out.push_back({size, 0});
+            misalign = true;
+        }
+        for (auto &s : m.sizes) {
+            out.push_back({s.size, 0});
+            counts.push_back(s.weight);
+        }
+        return true;
+    }
+    fprintf(stderr, "fastcsum-replay: unknown mix %s, one of:\n", name);
+    list_mixes();
+    return false;
+}
+
+int main(int argc, char **argv) {
+    static const option long_options[] = {
+        {"pcap", required_argument, nullptr, 'p'},
+        {"hist", required_argument, nullptr, 'H'},
+        {"mix", required_argument, nullptr, 'm'},
+        {"misalign", no_argument, nullptr, 'a'},
+        {"kernel", required_argument, nullptr, 'k'},
+        {"packets", required_argument, nullptr, 'n'},
+        {"rounds", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    options opt;
+    int c;
+    while ((c = getopt_long(argc, argv, "p:H:m:ak:n:r:h", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 'p':
+            opt.pcap = optarg;
+            break;
+        case 'H':
+            opt.hist = optarg;
+            break;
+        case 'm':
+            if (strcmp(optarg, "list") == 0) {
+                list_mixes();
+                return 0;
+            }
+            opt.mix = optarg;
+            break;
+        case 'a':
+            opt.misalign = true;
+            break;
+        case 'k': {
+            auto k = bench_kernel_find(optarg);
+            if (!k || !k->usable()) {
+                fprintf(stderr, "fastcsum-replay: kernel %s is unknown or not usable\n", optarg);
+                return 2;
+            }
+            opt.kernels.push_back(k);
+            break;
+        }
+        case 'n':
+            opt.packets = strtoull(optarg, nullptr, 10);
+            break;
+        case 'r':
+            opt.rounds = static_cast<unsigned int>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'h':
+            usage(stdout);
+            return 0;
+        default:
+            usage(stderr);
+            return 2;
+        }
+    }
+    if (!!opt.pcap + !!opt.hist + !!opt.mix != 1 || optind != argc || !opt.packets || !opt.rounds) {
+        usage(stderr);
+        return 2;
+    }
+
+    std::vector<bench_packet> samples;
+    std::vector<size_t> counts;
+    bool loaded = opt.pcap ? load_pcap(opt.pcap, samples)
+                  : opt.hist ? load_hist(opt.hist, samples, counts)
+                             : load_mix(opt.mix, samples, counts, opt.misalign);
+    if (!loaded)
+        return 2;
+    if (samples.empty()) {
+        fprintf(stderr, "fastcsum-replay: no packets to replay\n");
+        return 2;
+    }
+    if (counts.empty())
+        counts.assign(samples.size(), 1);
+    auto work = draw(samples, counts, opt.packets);
+    if (opt.misalign) {
+        std::mt19937 rnd(3);
+        for (auto &p : work)
+            p.offset = rnd() % bench_pool::line;
+    }
+
+    std::unique_ptr<bench_pool> pool;
+    try {
+        pool.reset(new bench_pool(work));
+    } catch (const std::bad_alloc &) {
+        fprintf(stderr, "fastcsum-replay: not enough memory for a pool of %zu packets\n", work.size());
+        return 2;
+    }
+    size_t bytes = 0;
+    std::vector<size_t> misalign(8);
+    for (auto &p : work) {
+        bytes += p.size;
+        misalign[p.offset % 8]++;
+    }
+    printf("%zu packets in a %.1f MiB pool, mean size %.1f bytes, offset mod 8:",
+           work.size(),
+           pool->bytes() / 1048576.0,
+           static_cast<double>(bytes) / work.size());
+    for (size_t i = 0; i < misalign.size(); i++)
+        printf(" %zu:%.0f%%", i, 100.0 * misalign[i] / work.size());
+    printf("\n\n%-16s %10s %10s %10s %10s\n", "kernel", "Mpps", "Gbps", "ns/pkt", "B/cycle");
+
+    if (opt.kernels.empty())
+        opt.kernels = bench_usable_kernels();
+    uint64_t sink = 0;
+    for (auto k : opt.kernels) {
+        double best = 1e30;
+        uint64_t best_ticks = 0;
+        for (unsigned int r = 0; r < opt.rounds; r++) {
+            bench_timer t;
+            for (size_t i = 0; i < work.size(); i++)
+                sink += k->fn((*pool)[i], work[i].size, 0);
+            t.stop();
+            if (t.seconds() < best) {
+                best = t.seconds();
+                best_ticks = t.ticks();
+            }
+        }
+        printf("%-16s %10.2f %10.2f %10.2f",
+               k->name,
+               work.size() / best / 1e6,
+               bytes * 8 / best / 1e9,
+               best * 1e9 / work.size());
+        if (best_ticks)
+            printf(" %10.2f\n", static_cast<double>(bytes) / best_ticks);
+        else
+            printf(" %10s\n", "-");
+    }
+    // keeps the sums from being optimized out
+    return sink == 1 ? 3 : 0;
+}
@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench-util.hpp"
+#include "fastcsum.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+struct options {
+    std::vector<const fastcsum_kernel *> kernels;
+    size_t size = 1472;
+    unsigned int batch = 64;
+    double duration = 1;
+    bool zerocopy = false;
+    int busy_poll = 0;
+};
+
+struct result {
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t queued = 0;
+    uint64_t bad = 0;
+    // wall time of the receive loop, which may overrun the requested duration by up to one receive timeout
+    double seconds = 0;
+    // receiver thread CPU time, and ticks of it spent verifying checksums
+    double cpu_seconds = 0;
+    uint64_t csum_ticks = 0;
+};
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "usage: fastcsum-udp [options]\n"
+            "Sends UDP datagrams over loopback and verifies their payload checksums in a recvmmsg loop, per kernel.\n"
+            "\n"
+            "  -k, --kernel NAME      only run this kernel (repeatable; \"none\" receives without verifying)\n"
+            "  -s, --size BYTES       UDP payload size (default 1472)\n"
+            "  -b, --batch N          datagrams per sendmmsg/recvmmsg call (default 64)\n"
+            "  -d, --duration SECS    receive time per kernel (default 1)\n"
+            "  -z, --zerocopy         send with MSG_ZEROCOPY\n"
+            "      --busy-poll USECS  set SO_BUSY_POLL on the receiving socket\n"
+            "  -h, --help             show this help\n");
+}
+
+// Baseline without checksum verification, to separate the cost of the receive path itself.
+static const fastcsum_kernel no_kernel = {"none", nullptr, bench_always_usable};
+
+static double thread_cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Reaps zerocopy completion notifications so they do not exhaust the socket's option memory.
+static void drain_errqueue(int fd) {
+    char control[128];
+    while (true) {
+        msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            return;
+    }
+}
+
+/*
+ * Sends `batch` distinct payloads in a loop until `stop`. Each payload carries its own checksum in its first two
+ * bytes, chosen so the one's complement sum of the whole payload is 0xffff and any kernel verifies it with no header.
+ */
+static bool run_sender(const options &opt, const sockaddr_in &to, std::atomic<bool> &stop, uint64_t &sent) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr *>(&to), sizeof(to)) < 0) {
+        perror("fastcsum-udp: sender");
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    int one = 1;
+    if (opt.zerocopy && setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+        perror("fastcsum-udp: SO_ZEROCOPY");
+        close(fd);
+        return false;
+    }
+
+    std::vector<uint8_t> payloads(opt.size * opt.batch);
+    std::mt19937_64 rnd(1);
+    for (auto &b : payloads)
+        b = static_cast<uint8_t>(rnd());
+    std::vector<iovec> iov(opt.batch);
+    std::vector<mmsghdr> msgs(opt.batch);
+    for (unsigned int i = 0; i < opt.batch; i++) {
+        auto p = payloads.data() + i * opt.size;
+        memset(p, 0, 2);
+        uint16_t csum = fastcsum_fold_complement(fastcsum_nofold(p, opt.size, 0));
+        memcpy(p, &csum, 2);
+        iov[i] = {p, opt.size};
+        msgs[i] = {};
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int flags = opt.zerocopy ? MSG_ZEROCOPY : 0;
+    bool ok = true;
+    while (!stop.load(std::memory_order_relaxed)) {
+        int n = sendmmsg(fd, msgs.data(), opt.batch, flags);
+        if (opt.zerocopy)
+            drain_errqueue(fd);
+        if (n > 0) {
+            sent += n;
+        } else if (errno != EINTR && errno != EAGAIN && errno != ENOBUFS && errno != ECONNREFUSED) {
+            perror("fastcsum-udp: sendmmsg");
+            ok = false;
+            break;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+static bool run(const options &opt, const fastcsum_kernel *k, result &res) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &addr_len) < 0) {
+        perror("fastcsum-udp: receiver");
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    int rcvbuf = 16 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    timeval timeout = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (opt.busy_poll && setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &opt.busy_poll, sizeof(opt.busy_poll)) < 0) {
+        perror("fastcsum-udp: SO_BUSY_POLL");
+        close(fd);
+        return false;
+    }
+
+    // one byte of slack so that oversized datagrams show up as truncated
+    size_t slot = opt.size + 1;
+    std::vector<uint8_t> buffers(slot * opt.batch);
+    std::vector<iovec> iov(opt.batch);
+    std::vector<mmsghdr> msgs(opt.batch);
+    for (unsigned int i = 0; i < opt.batch; i++) {
+        iov[i] = {buffers.data() + i * slot, slot};
+        msgs[i] = {};
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<bool> sender_ok(true);
+    uint64_t sent = 0;
+    std::thread sender([&] { sender_ok = run_sender(opt, addr, stop, sent); });
+
+    bool ok = true;
+    double cpu_start = thread_cpu_seconds();
+    bench_timer elapsed;
+    while (true) {
+        elapsed.stop();
+        if (elapsed.seconds() >= opt.duration || !sender_ok)
+            break;
+        int n = recvmmsg(fd, msgs.data(), opt.batch, MSG_WAITFORONE, nullptr);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            perror("fastcsum-udp: recvmmsg");
+            ok = false;
+            break;
+        }
+        res.received += n;
+        if (!k->fn)
+            continue;
+        auto start = bench_ticks();
+        for (int i = 0; i < n; i++) {
+            auto len = msgs[i].msg_len;
+            if (len != opt.size || fastcsum_fold_complement(k->fn(buffers.data() + i * slot, len, 0)) != 0)
+                res.bad++;
+        }
+        res.csum_ticks += bench_ticks() - start;
+    }
+    res.seconds = elapsed.seconds();
+    res.cpu_seconds = thread_cpu_seconds() - cpu_start;
+    stop = true;
+    sender.join();
+    res.sent = sent;
+    // datagrams still queued were delivered, only too late to be timed
+    int n;
+    while ((n = recvmmsg(fd, msgs.data(), opt.batch, MSG_DONTWAIT, nullptr)) > 0)
+        res.queued += n;
+    close(fd);
+    return ok && sender_ok;
+}
+
+int main(int argc, char **argv) {
+    enum { opt_busy_poll = 256 };
+    static const option long_options[] = {
+        {"kernel", required_argument, nullptr, 'k'},
+        {"size", required_argument, nullptr, 's'},
+        {"batch", required_argument, nullptr, 'b'},
+        {"duration", required_argument, nullptr, 'd'},
+        {"zerocopy", no_argument, nullptr, 'z'},
+        {"busy-poll", required_argument, nullptr, opt_busy_poll},
+        {"help", no_argument, nullptr, 'h'},
+        {},
+    };
+
+    options opt;
+    int c;
+    while ((c = getopt_long(argc, argv, "k:s:b:d:zh", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 'k': {
+            auto k = strcmp(optarg, no_kernel.name) == 0 ? &no_kernel : fastcsum_kernel_find(optarg);
+            if (!k || !k->usable()) {
+                fprintf(stderr, "fastcsum-udp: kernel %s is unknown or not usable\n", optarg);
+                return 2;
+            }
+            opt.kernels.push_back(k);
+            break;
+        }
+        case 's':
+            opt.size = strtoull(optarg, nullptr, 10);
+            break;
+        case 'b':
+            opt.batch = static_cast<unsigned int>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'd':
+            opt.duration = strtod(optarg, nullptr);
+            break;
+        case 'z':
+            opt.zerocopy = true;
+            break;
+        case opt_busy_poll:
+            opt.busy_poll = atoi(optarg);
+            break;
+        case 'h':
+            usage(stdout);
+            return 0;
+        default:
+            usage(stderr);
+            return 2;
+        }
+    }
+    // a payload below 2 bytes has no room for its checksum, 65507 is the IPv4 UDP maximum
+    if (optind != argc || opt.size < 2 || opt.size > 65507 || !opt.batch || opt.batch > 1024 ||
+        !(opt.duration > 0)) {
+        usage(stderr);
+        return 2;
+    }
+    if (opt.kernels.empty()) {
+        opt.kernels.push_back(&no_kernel);
+        size_t n;
+        auto all = fastcsum_kernels(&n);
+        for (size_t i = 0; i < n; i++)
+            if (all[i].usable())
+                opt.kernels.push_back(&all[i]);
+    }
+
+    double hz = bench_tick_hz();
+    printf("%zu-byte payloads, batches of %u%s\n\n", opt.size, opt.batch, opt.zerocopy ? ", MSG_ZEROCOPY" : "");
+    printf("%-16s %8s %8s %7s %12s %12s %7s\n", "kernel", "Mpps", "Gbps", "loss", "cycles/pkt", "csum cyc/pkt", "csum");
+    uint64_t bad = 0;
+    for (auto k : opt.kernels) {
+        result res;
+        if (!run(opt, k, res))
+            return 2;
+        bad += res.bad;
+        double pps = res.seconds > 0 ? res.received / res.seconds : 0;
+        printf("%-16s %8.3f %8.2f %6.1f%%",
+               k->name,
+               pps / 1e6,
+               pps * opt.size * 8 / 1e9,
+               res.sent ? 100.0 * (res.sent - std::min(res.sent, res.received + res.queued)) / res.sent : 0.0);
+        if (hz && res.received) {
+            double cycles = res.cpu_seconds * hz;
+            printf(" %12.0f %12.0f %6.1f%%\n",
+                   cycles / res.received,
+                   static_cast<double>(res.csum_ticks) / res.received,
+                   100.0 * res.csum_ticks / cycles);
+        } else {
+            printf(" %12s %12s %7s\n", "-", "-", "-");
+        }
+    }
+    if (bad)
+        fprintf(stderr, "fastcsum-udp: %" PRIu64 " datagrams failed verification\n", bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "fastcsum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fastcsum_index;
+
+/*
+ * Builds a tree of unfolded partial sums over `size` bytes at `ptr`, split into `leaf_size`-byte leaves. The buffer is
+ * not copied and must outlive the index; after modifying it, call `fastcsum_index_update` on the modified range.
+ * Memory use is about 16 bytes per leaf. Not thread-safe. Returns NULL on failure.
+ */
+struct fastcsum_index *fastcsum_index_create(const uint8_t *ptr, size_t size, size_t leaf_size);
+
+void fastcsum_index_destroy(struct fastcsum_index *idx);
+
+// Re-sums the leaves overlapping [offset, offset + len) and the O(log n) nodes above them.
+void fastcsum_index_update(struct fastcsum_index *idx, size_t offset, size_t len);
+
+/*
+ * Returns the unfolded sum of [start, end), relative to `start` as with `fastcsum_nofold(ptr + start, end - start, 0)`.
+ * Only the partial leaves at either end are read from the buffer. `end` is clamped to the buffer size.
+ */
+uint64_t fastcsum_index_query(const struct fastcsum_index *idx, size_t start, size_t end);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "fastcsum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fastcsum_memo;
+
+/*
+ * Creates a cache of unfolded sums of `chunk_size`-byte chunks of immutable buffers, keyed by a caller-chosen buffer ID
+ * and chunk index, for data that is checksummed repeatedly in different slices (e.g. TCP retransmissions from a send
+ * buffer). At most `max_entries` chunks are kept, evicting the least recently used; each costs about 64 bytes.
+ * Not thread-safe. Returns NULL on failure.
+ */
+struct fastcsum_memo *fastcsum_memo_create(size_t chunk_size, size_t max_entries);
+
+void fastcsum_memo_destroy(struct fastcsum_memo *memo);
+
+/*
+ * Returns the unfolded sum of base[offset, offset + len), relative to `offset`, where `base` is byte 0 of buffer
+ * `buffer_id`. Whole chunks are served from or added to the cache; the unaligned edges are summed directly.
+ */
+uint64_t fastcsum_memo_sum(
+    struct fastcsum_memo *memo,
+    uint64_t buffer_id,
+    const uint8_t *base,
+    size_t offset,
+    size_t len);
+
+// Drops all cached chunks of `buffer_id` that overlap [offset, offset + len). Pass SIZE_MAX to drop the whole buffer.
+void fastcsum_memo_invalidate(struct fastcsum_memo *memo, uint64_t buffer_id, size_t offset, size_t len);
+
+// Returns the number of cached chunks.
+size_t fastcsum_memo_entries(const struct fastcsum_memo *memo);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "fastcsum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Protocol-aware helpers built on the fastcsum_nofold implementations.
+ * Packet buffers are in network order; checksums are read and written in native order as with
+ * `fastcsum_fold_complement`.
+ */
+
+// Returns the unfolded sum of the IPv4 header at `hdr` of IHL `hdr[0] & 0xf`. IHL=5 headers take no loop.
+uint64_t fastcsum_nofold_ipv4_hdr(const uint8_t *hdr);
+
+// Returns true if the IPv4 header at `hdr` has IHL >= 5 and a valid checksum.
+bool fastcsum_ipv4_hdr_verify(const uint8_t *hdr);
+
+// Computes and stores the IPv4 header checksum. The old content of the checksum field is ignored.
+void fastcsum_ipv4_hdr_generate(uint8_t *hdr);
+
+/*
+ * Verifies `n` IPv4 headers. Sets bit i of `invalid` (an array of (n + 63) / 64 words) if header i does not verify.
+ * Returns the number of invalid headers.
+ */
+size_t fastcsum_ipv4_hdr_verify_batch(const uint8_t *const hdrs[], size_t n, uint64_t invalid[]);
+
+// One header at a time.
+size_t fastcsum_ipv4_hdr_verify_batch_generic(const uint8_t *const hdrs[], size_t n, uint64_t invalid[]);
+
+// 8 headers at a time, transposed into AVX2 lanes. Headers with IHL != 5 fall back to the scalar kernel.
+size_t fastcsum_ipv4_hdr_verify_batch_avx2(const uint8_t *const hdrs[], size_t n, uint64_t invalid[]);
+
+// Generates the checksums of `n` IPv4 headers in place, e.g. after a TTL decrement on the forwarding path.
+void fastcsum_ipv4_hdr_generate_batch(uint8_t *const hdrs[], size_t n);
+
+// One header at a time.
+void fastcsum_ipv4_hdr_generate_batch_generic(uint8_t *const hdrs[], size_t n);
+
+// 8 headers at a time, transposed into AVX2 lanes.
+void fastcsum_ipv4_hdr_generate_batch_avx2(uint8_t *const hdrs[], size_t n);
+
+// Returns the unfolded sum of the IPv4 pseudo-header. Addresses are in network order, `len` is the L4 length.
+uint64_t fastcsum_nofold_pseudo_v4(const uint8_t saddr[4], const uint8_t daddr[4], uint8_t proto, uint16_t len);
+
+// Returns the unfolded sum of the IPv6 pseudo-header. Addresses are in network order, `len` is the L4 length.
+uint64_t fastcsum_nofold_pseudo_v6(const uint8_t saddr[16], const uint8_t daddr[16], uint8_t proto, uint32_t len);
+
+/*
+ * Returns the folded, complemented checksum of the `len`-byte L4 segment at `l4` including the IPv4 pseudo-header,
+ * in one `fastcsum_nofold` call with the pseudo-header sum as the initial value.
+ * With the checksum field zeroed this is the value to store (UDP senders must still replace 0 with 0xffff);
+ * with the checksum field filled in, it returns 0 if the checksum is valid.
+ */
+uint16_t fastcsum_l4_v4(const uint8_t saddr[4], const uint8_t daddr[4], uint8_t proto, const uint8_t *l4, size_t len);
+
+// Same as `fastcsum_l4_v4` with the IPv6 pseudo-header.
+uint16_t fastcsum_l4_v6(const uint8_t saddr[16], const uint8_t daddr[16], uint8_t proto, const uint8_t *l4, size_t len);
+
+enum fastcsum_frame_flags {
+    FASTCSUM_FRAME_IPV4 = 1 << 0,
+    FASTCSUM_FRAME_IPV6 = 1 << 1,
+    FASTCSUM_FRAME_TCP = 1 << 2,
+    FASTCSUM_FRAME_UDP = 1 << 3,
+    FASTCSUM_FRAME_UDPLITE = 1 << 4,
+    // ICMP over IPv4 or ICMPv6 over IPv6
+    FASTCSUM_FRAME_ICMP = 1 << 5,
+    // IP fragment, whose L4 checksum cannot be checked on its own
+    FASTCSUM_FRAME_FRAGMENT = 1 << 6,
+    // UDP over IPv4 without a checksum
+    FASTCSUM_FRAME_NO_L4_CSUM = 1 << 7,
+    // bad IPv4 header checksum
+    FASTCSUM_FRAME_BAD_L3 = 1 << 8,
+    // bad TCP/UDP/UDP-Lite/ICMP checksum
+    FASTCSUM_FRAME_BAD_L4 = 1 << 9,
+    // truncated frame or inconsistent length fields
+    FASTCSUM_FRAME_MALFORMED = 1 << 10,
+};
+
+#define FASTCSUM_FRAME_ERRORS (FASTCSUM_FRAME_BAD_L3 | FASTCSUM_FRAME_BAD_L4 | FASTCSUM_FRAME_MALFORMED)
+
+struct fastcsum_frame_info {
+    // fastcsum_frame_flags
+    unsigned int flags;
+    uint8_t l4_proto;
+    // offsets from the start of the frame, 0 if absent
+    size_t l3_offset;
+    size_t l4_offset;
+    // L4 length according to the IP header
+    size_t l4_len;
+};
+
+/*
+ * Verifies every checksum of a raw Ethernet frame: the IPv4 header checksum and the TCP, UDP, UDP-Lite (within its
+ * coverage), ICMP or ICMPv6 checksum, after skipping VLAN/QinQ tags, IPv4 options and IPv6 extension headers.
+ * Each L4 segment is read once, with the pseudo-header sum as the initial value. The frame is not modified.
+ * Returns a combination of fastcsum_frame_flags; `info` may be NULL.
+ */
+unsigned int fastcsum_frame_verify(const uint8_t *frame, size_t len, struct fastcsum_frame_info *info);
+
+/*
+ * Same as `fastcsum_frame_verify` but fills in the checksums instead. The old checksum fields are ignored.
+ * Never sets FASTCSUM_FRAME_BAD_L3 or FASTCSUM_FRAME_BAD_L4.
+ */
+unsigned int fastcsum_frame_fill(uint8_t *frame, size_t len, struct fastcsum_frame_info *info);
+
+/*
+ * Verifies `n` frames, storing the flags of frame i in flags[i]. `infos` may be NULL.
+ * Returns the number of frames with any of FASTCSUM_FRAME_ERRORS.
+ */
+size_t fastcsum_frame_verify_batch(
+    const uint8_t *const frames[],
+    const size_t lens[],
+    size_t n,
+    unsigned int flags[],
+    struct fastcsum_frame_info infos[]);
+
+// Fills in the checksums of `n` frames, storing the flags of frame i in flags[i]. `infos` may be NULL.
+void fastcsum_frame_fill_batch(
+    uint8_t *const frames[],
+    const size_t lens[],
+    size_t n,
+    unsigned int flags[],
+    struct fastcsum_frame_info infos[]);
+
+/*
+ * Local checksum offload: an L4 segment whose checksum is filled in sums to the complement of its pseudo-header,
+ * so its unfolded sum can be derived from the pseudo-header sum without reading the segment.
+ */
+__attribute__((always_inline)) static inline uint64_t fastcsum_lco_sum(uint64_t pseudo) {
+    return ~pseudo;
+}
+
+/*
+ * Fills in the outer UDP checksum of a UDP-encapsulated packet (VXLAN, Geneve, GUE...) whose outer IPv4/IPv6 header
+ * starts at `outer_l3`, and whose inner IPv4/IPv6 header starts `inner_l3_offset` bytes later.
+ * Only the outer and inner headers are summed: the inner TCP/UDP/ICMP segment, whose checksum must already be filled
+ * in, is accounted for with `fastcsum_lco_sum`. Inner segments without a usable checksum are summed instead.
+ * Returns 0 on success or -1 if the headers are malformed.
+ */
+int fastcsum_encap_udp_lco(uint8_t *outer_l3, size_t len, size_t inner_l3_offset);
+
+/*
+ * Computes the TCP checksums of the segments produced by software segmentation (GSO/TSO) of `len` bytes of payload
+ * into `mss`-byte segments, touching the payload once.
+ * `tcp` is the `tcp_len`-byte TCP header (with options) of the super-packet. Segment i uses it with the sequence number
+ * advanced by i * mss, CWR cleared on all but the first segment and FIN/PSH cleared on all but the last.
+ * `saddr`/`daddr` are 4-byte IPv4 or, if `v6`, 16-byte IPv6 addresses for the pseudo-headers.
+ * Stores the checksum of segment i in csums[i] and returns the number of segments.
+ */
+size_t fastcsum_gso_tcp(
+    bool v6,
+    const uint8_t *saddr,
+    const uint8_t *daddr,
+    const uint8_t *tcp,
+    size_t tcp_len,
+    const uint8_t *payload,
+    size_t len,
+    size_t mss,
+    uint16_t csums[]);
+
+// GRO coalescing state. Zero-initialize before the first `fastcsum_gro_push`.
+struct fastcsum_gro {
+    // unfolded sum of the coalesced payload so far
+    uint64_t payload_sum;
+    size_t payload_len;
+    size_t nsegs;
+};
+
+/*
+ * Appends the payload of a TCP segment whose checksum was already verified. The payload sum is derived from the
+ * segment's pseudo-header sum `pseudo` and its `tcp_len`-byte TCP header (checksum included) without reading the
+ * payload, and is placed after the previous payloads with parity correction.
+ */
+void fastcsum_gro_push(struct fastcsum_gro *g, uint64_t pseudo, const uint8_t *tcp, size_t tcp_len, size_t payload_len);
+
+/*
+ * Returns the checksum of the merged segment made of the `tcp_len`-byte TCP header `tcp`, whose checksum field is
+ * ignored, followed by the coalesced payload. `pseudo` is the pseudo-header sum for the merged length.
+ */
+uint16_t fastcsum_gro_finish(const struct fastcsum_gro *g, uint64_t pseudo, const uint8_t *tcp, size_t tcp_len);
+
+#define FASTCSUM_FRAG_MAX_RANGES 16
+
+struct fastcsum_frag_range {
+    size_t start;
+    size_t end;
+};
+
+// IP fragment reassembly checksum state. Zero-initialize before the first `fastcsum_frag_add`.
+struct fastcsum_frag {
+    // unfolded sum of the bytes received so far, relative to the start of the reassembled payload
+    uint64_t sum;
+    size_t received;
+    // payload length, known once the last fragment has arrived
+    size_t total;
+    // received byte ranges, sorted and with adjacent ranges merged
+    unsigned int nranges;
+    struct fastcsum_frag_range ranges[FASTCSUM_FRAG_MAX_RANGES];
+};
+
+/*
+ * Adds the `len`-byte fragment `data` found at `offset` in the reassembled payload, in any arrival order. `last` is set
+ * for the fragment without the more-fragments flag.
+ * Returns 1 once every byte up to the end of the last fragment has arrived, at which point `f->sum` is the unfolded sum
+ * of the whole L4 segment; 0 while fragments are missing; -1 if the fragment overlaps one already received (which
+ * RFC 5722 requires to drop the datagram), conflicts with the last fragment or would leave more than
+ * FASTCSUM_FRAG_MAX_RANGES holes. A rejected fragment leaves `f` unchanged.
+ */
+int fastcsum_frag_add(struct fastcsum_frag *f, size_t offset, const uint8_t *data, size_t len, bool last);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "fastcsum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fastcsum_offload;
+
+struct fastcsum_offload_desc {
+    const uint8_t *ptr;
+    size_t len;
+    uint64_t initial;
+    // Unfolded sum, filled in by the worker.
+    uint64_t result;
+    // Not touched by the library; identifies the request on completion.
+    void *completion;
+};
+
+/*
+ * Starts `nworkers` checksum worker threads, each fed by a lock-free single-producer ring of `depth` descriptors
+ * (rounded up to a power of 2). Workers run `fastcsum_nofold` and post completed descriptors in batches to a shared
+ * multi-producer completion ring.
+ * Submission and polling must be done from a single thread (e.g. a run-to-completion loop).
+ * Returns NULL on failure.
+ */
+struct fastcsum_offload *fastcsum_offload_create(unsigned int nworkers, size_t depth, enum fastcsum_affinity affinity);
+
+// Stops the workers. Descriptors that are still in flight are dropped.
+void fastcsum_offload_destroy(struct fastcsum_offload *q);
+
+// Queues up to `n` descriptors round-robin across workers without blocking. Returns the number queued.
+size_t fastcsum_offload_submit(struct fastcsum_offload *q, const struct fastcsum_offload_desc *descs, size_t n);
+
+// Retrieves up to `n` completed descriptors without blocking. Returns the number retrieved.
+size_t fastcsum_offload_poll(struct fastcsum_offload *q, struct fastcsum_offload_desc *out, size_t n);
+
+// Returns the number of descriptors submitted but not yet retrieved by `fastcsum_offload_poll`.
+size_t fastcsum_offload_inflight(const struct fastcsum_offload *q);
+
+#ifdef __cplusplus
+}
+#endif
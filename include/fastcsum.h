@@ -15,6 +15,8 @@ extern "C" {
         return fastcsum_built_with_##feat() && fastcsum_cpu_has_##feat(); \
     }
 
+typedef uint64_t (*fastcsum_nofold_fn)(const uint8_t *ptr, size_t size, uint64_t initial);
+
 // Unrolled 32 bytes/loop add-with-carry implementation.
 uint64_t fastcsum_nofold_generic64(const uint8_t *b, size_t size, uint64_t initial);
 
@@ -98,6 +100,145 @@ uint64_t fastcsum_nofold_vec128(const uint8_t *ptr, size_t size, uint64_t initia
 // 128 bytes/loop 16-byte vector-based version with parallel addition and load alignment.
 uint64_t fastcsum_nofold_vec128_align(const uint8_t *ptr, size_t size, uint64_t initial);
 
+// Runtime-dispatched implementation: adx_v2 on ADX-capable CPUs, x64_64b on other x86-64 CPUs, generic64 otherwise.
+uint64_t fastcsum_nofold(const uint8_t *ptr, size_t size, uint64_t initial);
+
+// Returns the implementation used by `fastcsum_nofold`, for callers that want to skip the dispatch in hot loops.
+fastcsum_nofold_fn fastcsum_nofold_best();
+
+struct fastcsum_kernel {
+    // function name without the `fastcsum_nofold_` prefix, e.g. "adx_v2"
+    const char *name;
+    fastcsum_nofold_fn fn;
+    // Returns whether the kernel can run with this build on this CPU.
+    bool (*usable)(void);
+};
+
+// Returns the non-deprecated kernels built into the library and stores their number in `*n`.
+const struct fastcsum_kernel *fastcsum_kernels(size_t *n);
+
+// Returns the kernel called `name`, or NULL if there is none.
+const struct fastcsum_kernel *fastcsum_kernel_find(const char *name);
+
+enum fastcsum_affinity {
+    // Worker threads are left to the scheduler.
+    FASTCSUM_AFFINITY_NONE,
+    // Worker N is pinned to the Nth CPU of the process affinity mask.
+    FASTCSUM_AFFINITY_CPU,
+    // Workers are pinned round-robin to the CPUs of each NUMA node in turn.
+    FASTCSUM_AFFINITY_NODE,
+};
+
+/*
+ * Splits the buffer into cache line-aligned chunks and sums them with `fastcsum_nofold` on up to `nthreads` threads
+ * (including the calling thread) of an internal thread pool. nthreads = 0 uses one thread per CPU.
+ * Small buffers are summed on the calling thread only.
+ */
+uint64_t fastcsum_nofold_parallel(const uint8_t *ptr, size_t size, uint64_t initial, unsigned int nthreads);
+
+// Sets how the worker threads of `fastcsum_nofold_parallel` are pinned. Restarts the thread pool.
+void fastcsum_parallel_set_affinity(enum fastcsum_affinity affinity);
+
+/*
+ * Sums `size` bytes as if the byte ranges [skip_offsets[i], skip_offsets[i] + skip_lens[i]) were zero, without copying
+ * or modifying the buffer, e.g. to verify or compute a header checksum with the checksum field in place.
+ * Ranges may be given in any order and may overlap; parts beyond `size` are ignored.
+ */
+uint64_t fastcsum_nofold_skip(
+    const uint8_t *ptr,
+    size_t size,
+    uint64_t initial,
+    const size_t skip_offsets[],
+    const size_t skip_lens[],
+    size_t n);
+
+/*
+ * Walks `size` bytes once and stores the unfolded sum of each `seg_size`-byte segment (the last one may be shorter) in
+ * out[0..], each relative to the start of its own segment, so odd segment sizes need no correction.
+ * Returns the number of segments.
+ */
+size_t fastcsum_nofold_segments(const uint8_t *ptr, size_t size, size_t seg_size, uint64_t out[]);
+
+/*
+ * Stores the folded and complemented checksum of each `block_size`-byte block (the last one may be shorter) in
+ * out[0..], as kept per block by storage and dedup workloads. On AVX2 CPUs, blocks under 128 bytes go through
+ * `fastcsum_blocks_avx2` and larger ones through one `fastcsum_nofold_avx2_v7` call each, whichever measured faster;
+ * other CPUs make one `fastcsum_nofold` call per block. Returns the number of blocks.
+ */
+size_t fastcsum_blocks(const uint8_t *ptr, size_t size, size_t block_size, uint16_t out[]);
+
+// Single AVX2 pass over the buffer that folds and stores a result at each block boundary, with no per-block call.
+size_t fastcsum_blocks_avx2(const uint8_t *ptr, size_t size, size_t block_size, uint16_t out[]);
+
+// Same as `fastcsum_blocks` on up to `nthreads` threads (0 for one per CPU) of the `fastcsum_nofold_parallel` pool.
+size_t fastcsum_blocks_parallel(
+    const uint8_t *ptr,
+    size_t size,
+    size_t block_size,
+    uint16_t out[],
+    unsigned int nthreads);
+
+/*
+ * Computes the unfolded sum of each range [starts[i], ends[i]) of one buffer into out[i], relative to the start of its
+ * own range, reading every byte of the union of the ranges once. Meant for the few overlapping sums of an encapsulated
+ * frame. Ranges are clamped to `size`; empty ranges yield 0.
+ */
+void fastcsum_nofold_ranges(
+    const uint8_t *ptr,
+    size_t size,
+    const size_t starts[],
+    const size_t ends[],
+    size_t n,
+    uint64_t out[]);
+
+/*
+ * Sums `n` independent packets into out[0..n-1]. Meant for vectors of small packets where per-call setup and tail
+ * handling dominate. `initials` may be NULL.
+ * Uses `fastcsum_nofold_batch_avx2` on AVX2 CPUs without ADX and `fastcsum_nofold_batch_generic` otherwise.
+ */
+void fastcsum_nofold_batch(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t out[]);
+
+// One `fastcsum_nofold` call per packet.
+void fastcsum_nofold_batch_generic(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t out[]);
+
+// 8 packets at a time, one per 64-bit AVX2 lane, using masked gathers for packets of different lengths.
+void fastcsum_nofold_batch_avx2(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t out[]);
+
+// Same as `fastcsum_nofold_batch` but stores folded, complemented checksums.
+void fastcsum_batch_fold_complement(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint16_t out[]);
+
+/*
+ * Verifies `n` packets whose checksum fields are included in the summed data.
+ * Sets bit i of `mismatch` (an array of (n + 63) / 64 words) if packet i does not verify.
+ * Returns the number of mismatches.
+ */
+size_t fastcsum_batch_verify(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t mismatch[]);
+
 /*
  * Returns folded, complemented checksum in native byte order.
  * Note that initial, partial and final checksum values must all be loaded and stored in **native** order.
@@ -115,6 +256,41 @@ __attribute__((always_inline)) static inline uint16_t fastcsum_fold_complement(u
     return ~ac16;
 }
 
+// Adds two unfolded sums with end-around carry.
+__attribute__((always_inline)) static inline uint64_t fastcsum_add(uint64_t a, uint64_t b) {
+    uint64_t s;
+    bool c = __builtin_add_overflow(a, b, &s);
+    return s + c;
+}
+
+/*
+ * Adds the unfolded sum `b` of bytes starting at byte offset `offset` into the data summed by `a`.
+ * Odd offsets shift every 16-bit word by one byte, which is corrected by byte-swapping `b`.
+ */
+__attribute__((always_inline)) static inline uint64_t fastcsum_combine(uint64_t a, uint64_t b, size_t offset) {
+    if (offset & 1)
+        b = __builtin_bswap64(b);
+    return fastcsum_add(a, b);
+}
+
+/*
+ * Incremental checksum update following RFC 1624 eqn. 3: HC' = ~(~HC + ~m + m').
+ * Unlike eqn. 2, this matches a full recomputation including when the new checksum is 0x0000, the only exception
+ * being data that becomes all zeros.
+ * The checksum and the old/new field values are in native order as stored in the packet, and the field must start at
+ * an even offset from the start of the checksummed data (see `fastcsum_update_range` otherwise).
+ */
+__attribute__((always_inline)) static inline uint16_t
+fastcsum_update16(uint16_t csum, uint16_t old_val, uint16_t new_val) {
+    return fastcsum_fold_complement((uint64_t)(uint16_t)~csum + (uint16_t)~old_val + new_val);
+}
+
+// Same as `fastcsum_update16` for a 32-bit field such as an IPv4 address.
+__attribute__((always_inline)) static inline uint16_t
+fastcsum_update32(uint16_t csum, uint32_t old_val, uint32_t new_val) {
+    return fastcsum_fold_complement((uint64_t)(uint16_t)~csum + (uint32_t)~old_val + new_val);
+}
+
 /*
  * The reason why checksums must be loaded/stored in native order is that fastcsum_nofold calculates the 1's complement
  * sum using native byte order.
@@ -127,6 +303,73 @@ __attribute__((always_inline)) static inline uint16_t fastcsum_fold_complement(u
  * However, byte_repr_BE(0x3412) == 34 12 == byte_repr_LE(0x1234).
  */
 
+#define FASTCSUM_TEMPLATE_MAX_FIELDS 16
+
+struct fastcsum_template {
+    // Unfolded sum of the template with all variable fields treated as zero.
+    uint64_t base;
+    size_t len;
+    size_t nfields;
+    struct {
+        size_t offset;
+        size_t len;
+        // selects the field bytes out of a qword load at `offset`, 0 if the field needs a full sum
+        uint64_t mask;
+    } fields[FASTCSUM_TEMPLATE_MAX_FIELDS];
+};
+
+/*
+ * Precomputes the sum of the constant bytes of the `len`-byte template `tmpl`.
+ * The variable fields are given by offsets[0..nfields-1] and lens[0..nfields-1] and must not overlap.
+ * Returns false if there are more than FASTCSUM_TEMPLATE_MAX_FIELDS fields or a field is out of bounds or overlaps
+ * another.
+ */
+bool fastcsum_template_init(
+    struct fastcsum_template *t,
+    const uint8_t *tmpl,
+    size_t len,
+    const size_t offsets[],
+    const size_t lens[],
+    size_t nfields);
+
+/*
+ * Returns the unfolded sum of a packet built from the template by reading only its variable fields, so the cost
+ * does not depend on the packet size.
+ */
+uint64_t fastcsum_template_sum(const struct fastcsum_template *t, const uint8_t *pkt);
+
+/*
+ * Updates checksum `csum` after the `len` bytes at `old_bytes` were replaced with `new_bytes`.
+ * Only the parity of `offset`, the position of the bytes from the start of the checksummed data, matters.
+ */
+uint16_t
+fastcsum_update_range(uint16_t csum, const uint8_t *old_bytes, const uint8_t *new_bytes, size_t len, size_t offset);
+
+// Applies `fastcsum_update16` to csums[0..n-1] in place.
+void fastcsum_update16_batch(uint16_t csums[], const uint16_t old_vals[], const uint16_t new_vals[], size_t n);
+
+// Applies `fastcsum_update32` to csums[0..n-1] in place.
+void fastcsum_update32_batch(uint16_t csums[], const uint32_t old_vals[], const uint32_t new_vals[], size_t n);
+
+/*
+ * For each of the `n` packets, replaces the 16-bit field at `field_off` with new_vals[i] and updates the checksum
+ * at `csum_off` accordingly. Both offsets must be even relative to the start of the checksummed data.
+ */
+void fastcsum_rewrite16_batch(
+    uint8_t *const pkts[],
+    size_t n,
+    size_t csum_off,
+    size_t field_off,
+    const uint16_t new_vals[]);
+
+// Same as `fastcsum_rewrite16_batch` for a 32-bit field.
+void fastcsum_rewrite32_batch(
+    uint8_t *const pkts[],
+    size_t n,
+    size_t csum_off,
+    size_t field_off,
+    const uint32_t new_vals[]);
+
 #ifdef __cplusplus
 }
 #endif
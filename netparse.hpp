@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Header parsing shared by the frame-level helpers. Lengths are checked against the buffer; nothing is written.
+
+static inline uint16_t load_be16(const uint8_t *p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// Returns the native value whose byte representation is `v` in network order.
+static inline uint32_t net32(uint32_t v) {
+    return __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ ? v : __builtin_bswap32(v);
+}
+
+enum : uint16_t {
+    ETHTYPE_IPV4 = 0x0800,
+    ETHTYPE_IPV6 = 0x86dd,
+    ETHTYPE_VLAN = 0x8100,
+    ETHTYPE_QINQ = 0x88a8,
+    ETHTYPE_QINQ_OLD = 0x9100,
+};
+
+enum : uint8_t {
+    PROTO_HOPOPTS = 0,
+    PROTO_ICMP = 1,
+    PROTO_TCP = 6,
+    PROTO_UDP = 17,
+    PROTO_ROUTING = 43,
+    PROTO_FRAGMENT = 44,
+    PROTO_AH = 51,
+    PROTO_ICMPV6 = 58,
+    PROTO_NONE = 59,
+    PROTO_DSTOPTS = 60,
+    PROTO_UDPLITE = 136,
+};
+
+// Skips the Ethernet header and any VLAN/QinQ tags. Returns false if the frame is truncated.
+static inline bool parse_l2(const uint8_t *frame, size_t len, uint16_t &ethertype, size_t &l3_offset) {
+    size_t off = 12;
+    while (true) {
+        if (off + 2 > len)
+            return false;
+        ethertype = load_be16(&frame[off]);
+        off += 2;
+        if (ethertype != ETHTYPE_VLAN && ethertype != ETHTYPE_QINQ && ethertype != ETHTYPE_QINQ_OLD)
+            break;
+        off += 2;
+    }
+    l3_offset = off;
+    return true;
+}
+
+struct l3_info {
+    bool v6;
+    // set if this is a fragment, whose L4 checksum cannot be checked on its own
+    bool fragment;
+    uint8_t proto;
+    // addresses for the pseudo-header; daddr is the final destination if there is a routing header
+    const uint8_t *saddr;
+    const uint8_t *daddr;
+    // offset of the L4 header from the start of the L3 header
+    size_t l4_offset;
+    size_t l4_len;
+};
+
+// Parses an IPv4 header and its total length. Returns false if malformed.
+static inline bool parse_ipv4(const uint8_t *l3, size_t len, l3_info &info) {
+    if (len < 20 || (l3[0] >> 4) != 4)
+        return false;
+    size_t hlen = (l3[0] & 0xf) * 4;
+    size_t tot = load_be16(&l3[2]);
+    if (hlen < 20 || tot < hlen || tot > len)
+        return false;
+    info.v6 = false;
+    info.fragment = (load_be16(&l3[6]) & 0x3fff) != 0;
+    info.proto = l3[9];
+    info.saddr = &l3[12];
+    info.daddr = &l3[16];
+    info.l4_offset = hlen;
+    info.l4_len = tot - hlen;
+    return true;
+}
+
+// Parses an IPv6 header and walks its extension headers up to the upper-layer header. Returns false if malformed.
+static inline bool parse_ipv6(const uint8_t *l3, size_t len, l3_info &info) {
+    if (len < 40 || (l3[0] >> 4) != 6)
+        return false;
+    size_t end = 40 + static_cast<size_t>(load_be16(&l3[4]));
+    if (end > len)
+        return false;
+    info.v6 = true;
+    info.fragment = false;
+    info.saddr = &l3[8];
+    info.daddr = &l3[24];
+
+    uint8_t nh = l3[6];
+    size_t off = 40;
+    while (true) {
+        size_t hlen;
+        switch (nh) {
+        case PROTO_HOPOPTS:
+        case PROTO_DSTOPTS:
+            if (off + 8 > end)
+                return false;
+            hlen = (static_cast<size_t>(l3[off + 1]) + 1) * 8;
+            break;
+        case PROTO_ROUTING: {
+            if (off + 8 > end)
+                return false;
+            hlen = (static_cast<size_t>(l3[off + 1]) + 1) * 8;
+            if (off + hlen > end)
+                return false;
+            uint8_t type = l3[off + 2];
+            uint8_t segments_left = l3[off + 3];
+            size_t naddrs = l3[off + 1] / 2;
+            if (segments_left && naddrs) {
+                // RFC 8200 8.1: the pseudo-header uses the final destination
+                if (type == 4)
+                    info.daddr = &l3[off + 8];
+                else if (type == 0 || type == 2)
+                    info.daddr = &l3[off + 8 + (naddrs - 1) * 16];
+            }
+            break;
+        }
+        case PROTO_FRAGMENT:
+            if (off + 8 > end)
+                return false;
+            hlen = 8;
+            if (load_be16(&l3[off + 2]) & 0xfff9)
+                info.fragment = true;
+            break;
+        case PROTO_AH:
+            if (off + 8 > end)
+                return false;
+            hlen = (static_cast<size_t>(l3[off + 1]) + 2) * 4;
+            break;
+        default:
+            info.proto = nh;
+            info.l4_offset = off;
+            info.l4_len = end - off;
+            return true;
+        }
+        if (off + hlen > end)
+            return false;
+        nh = l3[off];
+        off += hlen;
+        if (info.fragment) {
+            info.proto = nh;
+            info.l4_offset = off;
+            info.l4_len = end - off;
+            return true;
+        }
+    }
+}
+
+static inline bool parse_l3(const uint8_t *l3, size_t len, uint16_t ethertype, l3_info &info) {
+    if (ethertype == ETHTYPE_IPV4)
+        return parse_ipv4(l3, len, info);
+    else if (ethertype == ETHTYPE_IPV6)
+        return parse_ipv6(l3, len, info);
+    return false;
+}
+
+// Returns the offset of the checksum field in the L4 header, or -1 if the protocol has no checksum we handle.
+static inline int l4_csum_offset(uint8_t proto, size_t &min_len) {
+    switch (proto) {
+    case PROTO_TCP:
+        min_len = 20;
+        return 16;
+    case PROTO_UDP:
+    case PROTO_UDPLITE:
+        min_len = 8;
+        return 6;
+    case PROTO_ICMP:
+    case PROTO_ICMPV6:
+        min_len = 4;
+        return 2;
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static constexpr uint32_t LINKTYPE_ETHERNET = 1;
+
+struct pcap_frame {
+    uint8_t *data;
+    // bytes present in the capture
+    size_t caplen;
+    // length on the wire, larger than `caplen` for frames cut at the snapshot length
+    size_t origlen;
+    uint32_t linktype;
+};
+
+/*
+ * Reads the frames of a memory-mapped pcap or pcapng capture in file order. Readers are cheap to copy, so a reader
+ * positioned at any frame can be handed to another thread.
+ */
+class pcap_reader {
+public:
+    // Parses the file header. Returns false if the data is not a pcap or pcapng capture.
+    bool open(uint8_t *data, size_t size) {
+        base = data;
+        len = size;
+        if (size < 4)
+            return false;
+        uint32_t magic;
+        memcpy(&magic, data, 4);
+        if (magic == pcapng_shb) {
+            ng = true;
+            pos = 0;
+            // the section header block is then skipped like any other block by `next`
+            return read_shb();
+        }
+        if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
+            swap = false;
+        } else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1) {
+            swap = true;
+        } else {
+            return false;
+        }
+        if (size < 24)
+            return false;
+        ng = false;
+        linktype = rd32(data + 20) & 0xffff;
+        pos = 24;
+        return true;
+    }
+
+    // Returns the next frame, or false at the end of the capture or on a damaged record (see `damaged`).
+    bool next(pcap_frame &frame) {
+        return ng ? next_ng(frame) : next_pcap(frame);
+    }
+
+    // Returns true if reading stopped at a truncated or inconsistent record rather than at the end of the file.
+    bool damaged() const {
+        return bad;
+    }
+
+    bool is_pcapng() const {
+        return ng;
+    }
+
+private:
+    static constexpr uint32_t pcapng_shb = 0x0a0d0d0a;
+    static constexpr uint32_t pcapng_idb = 1;
+    static constexpr uint32_t pcapng_opb = 2;
+    static constexpr uint32_t pcapng_spb = 3;
+    static constexpr uint32_t pcapng_epb = 6;
+    static constexpr uint32_t pcapng_bom = 0x1a2b3c4d;
+
+    uint32_t rd32(const uint8_t *p) const {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return swap ? __builtin_bswap32(v) : v;
+    }
+
+    uint16_t rd16(const uint8_t *p) const {
+        uint16_t v;
+        memcpy(&v, p, 2);
+        return swap ? __builtin_bswap16(v) : v;
+    }
+
+    bool fail() {
+        bad = true;
+        return false;
+    }
+
+    bool next_pcap(pcap_frame &frame) {
+        if (pos == len)
+            return false;
+        if (len - pos < 16)
+            return fail();
+        auto caplen = rd32(base + pos + 8);
+        auto origlen = rd32(base + pos + 12);
+        if (caplen > len - pos - 16)
+            return fail();
+        frame = {base + pos + 16, caplen, origlen, linktype};
+        pos += 16 + caplen;
+        return true;
+    }
+
+    // Starts a new section at `pos`: byte order and interfaces are per section.
+    bool read_shb() {
+        if (len - pos < 28)
+            return false;
+        uint32_t bom;
+        memcpy(&bom, base + pos + 8, 4);
+        if (bom == pcapng_bom)
+            swap = false;
+        else if (bom == __builtin_bswap32(pcapng_bom))
+            swap = true;
+        else
+            return false;
+        interfaces.clear();
+        return true;
+    }
+
+    bool next_ng(pcap_frame &frame) {
+        while (pos < len) {
+            if (len - pos < 12)
+                return fail();
+            uint32_t type;
+            memcpy(&type, base + pos, 4);
+            if (type == pcapng_shb && !read_shb())
+                return fail();
+            type = rd32(base + pos);
+            auto total = rd32(base + pos + 4);
+            if (total < 12 || total % 4 || total > len - pos)
+                return fail();
+            auto body = base + pos + 8;
+            auto body_len = total - 12;
+            pos += total;
+
+            switch (type) {
+            case pcapng_idb:
+                if (body_len < 8)
+                    return fail();
+                interfaces.push_back({rd16(body), rd32(body + 4)});
+                break;
+            case pcapng_epb:
+            case pcapng_opb: {
+                if (body_len < 20)
+                    return fail();
+                auto ifid = type == pcapng_epb ? rd32(body) : rd16(body);
+                auto caplen = rd32(body + 12);
+                if (ifid >= interfaces.size() || caplen > body_len - 20)
+                    return fail();
+                frame = {body + 20, caplen, rd32(body + 16), interfaces[ifid].linktype};
+                return true;
+            }
+            case pcapng_spb: {
+                if (body_len < 4 || interfaces.empty())
+                    return fail();
+                size_t origlen = rd32(body);
+                size_t caplen = origlen;
+                if (interfaces[0].snaplen && caplen > interfaces[0].snaplen)
+                    caplen = interfaces[0].snaplen;
+                if (caplen > body_len - 4)
+                    return fail();
+                frame = {body + 4, caplen, origlen, interfaces[0].linktype};
+                return true;
+            }
+            default:
+                // section headers, statistics, name resolution, custom blocks...
+                break;
+            }
+        }
+        return false;
+    }
+
+    struct interface {
+        uint32_t linktype;
+        uint32_t snaplen;
+    };
+
+    uint8_t *base = nullptr;
+    size_t len = 0;
+    size_t pos = 0;
+    bool ng = false;
+    bool swap = false;
+    bool bad = false;
+    uint32_t linktype = 0;
+    std::vector<interface> interfaces;
+};
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Round-trips a checksum list through fastcsum-file -c, including a file with '@' in its name and a per-block list.
+set -eu
+
+tool=$1
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+head -c 100000 /dev/urandom > "$dir/user@host.bin"
+head -c 100000 /dev/urandom > "$dir/plain.bin"
+"$tool" -q -b 4096 "$dir/user@host.bin" "$dir/plain.bin" > "$dir/list"
+"$tool" -q -c "$dir/list" > "$dir/out"
+[ "$(grep -c ': OK$' "$dir/out")" -eq 2 ] || { cat "$dir/out"; exit 1; }
+
+# a corrupted file whose name contains '@' must fail the check
+printf 'x' | dd of="$dir/user@host.bin" bs=1 seek=5000 conv=notrunc 2>/dev/null
+if "$tool" -q -c "$dir/list" > "$dir/out"; then
+    echo "corruption of user@host.bin not detected"
+    exit 1
+fi
+grep -q "user@host.bin: FAILED$" "$dir/out" || { cat "$dir/out"; exit 1; }
+
+# a listed file that disappeared is reported, even when its name looks like a block line
+head -c 1000 /dev/urandom > "$dir/gone@7"
+"$tool" -q "$dir/gone@7" > "$dir/list"
+rm "$dir/gone@7"
+if "$tool" -q -c "$dir/list" > "$dir/out"; then
+    echo "missing gone@7 not reported"
+    exit 1
+fi
+grep -q "gone@7: FAILED open or read" "$dir/out" || { cat "$dir/out"; exit 1; }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <cstdio>
@@ -5,6 +6,8 @@
 #include <vector>
 #include <memory>
 #include <random>
+#include <string>
+#include <thread>
 #include <arpa/inet.h>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_get_random_seed.hpp>
@@ -13,6 +16,10 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 
 #include "fastcsum.h"
+#include "fastcsum-offload.h"
+#include "fastcsum-net.h"
+#include "fastcsum-index.h"
+#include "fastcsum-memo.h"
 #include "addc.hpp"
 
 #define TEST_CSUM(ref, impl, b, size, initial) \
@@ -204,6 +211,701 @@ TEST_CASE("checksum-rfc1071") {
     test_all(ref, pkt.data(), pkt.size(), 0);
 }
 
+TEST_CASE("checksum-dispatch") {
+    uint16_t initial = GENERATE(0, 0x1234, 0xfedc);
+    auto size = GENERATE(Catch::Generators::range(1, 300));
+    auto pkt = create_packet(size);
+    auto ref = checksum_ref(pkt.data(), pkt.size(), initial);
+    TEST_CSUM(ref, fastcsum_nofold, pkt.data(), pkt.size(), initial);
+    TEST_CSUM(ref, fastcsum_nofold_best(), pkt.data(), pkt.size(), initial);
+}
+
+TEST_CASE("checksum-kernels") {
+    auto size = GENERATE(1, 63, 1500);
+    auto pkt = create_packet(size);
+    auto ref = checksum_ref(pkt.data(), pkt.size(), 0);
+    size_t n;
+    auto kernels = fastcsum_kernels(&n);
+    REQUIRE(n > 0);
+    for (size_t i = 0; i < n; i++) {
+        REQUIRE(fastcsum_kernel_find(kernels[i].name) == &kernels[i]);
+        if (kernels[i].usable())
+            TEST_CSUM(ref, kernels[i].fn, pkt.data(), pkt.size(), 0);
+    }
+    REQUIRE(fastcsum_kernel_find("no_such_kernel") == nullptr);
+}
+
+TEST_CASE("checksum-parallel") {
+    uint16_t initial = GENERATE(0, 0x1234, 0xfedc);
+    auto nthreads = GENERATE(0, 1, 2, 3, 7);
+    auto off = GENERATE(0, 1, 63);
+    auto size = GENERATE(1000, (3 << 20) + 1, (5 << 20) + 3);
+    auto pkt = create_packet(off + size);
+    auto ref = checksum_ref(&pkt[off], size, initial);
+    REQUIRE(ref == fastcsum_fold_complement(fastcsum_nofold_parallel(&pkt[off], size, initial, nthreads)));
+}
+
+TEST_CASE("checksum-parallel-affinity") {
+    auto affinity = GENERATE(FASTCSUM_AFFINITY_CPU, FASTCSUM_AFFINITY_NODE, FASTCSUM_AFFINITY_NONE);
+    size_t size = (4 << 20) + 5;
+    auto pkt = create_packet(size);
+    auto ref = checksum_ref(pkt.data(), size, 0);
+    fastcsum_parallel_set_affinity(affinity);
+    REQUIRE(ref == fastcsum_fold_complement(fastcsum_nofold_parallel(pkt.data(), size, 0, 4)));
+}
+
+TEST_CASE("checksum-offload") {
+    auto nworkers = GENERATE(1, 3);
+    auto q = fastcsum_offload_create(nworkers, 8, FASTCSUM_AFFINITY_NONE);
+    REQUIRE(q);
+    auto pkt = create_packet(4096);
+    std::vector<fastcsum_offload_desc> descs(1000);
+    for (size_t i = 0; i < descs.size(); i++)
+        descs[i] = {&pkt[i % 64], 1 + i * 37 % 4000, static_cast<uint16_t>(i * 7), 0, &descs[i]};
+    std::vector<bool> seen(descs.size());
+
+    size_t submitted = 0, completed = 0;
+    while (completed < descs.size()) {
+        submitted += fastcsum_offload_submit(q, &descs[submitted], descs.size() - submitted);
+        fastcsum_offload_desc out[16];
+        auto n = fastcsum_offload_poll(q, out, 16);
+        if (!n)
+            std::this_thread::yield();
+        for (size_t i = 0; i < n; i++) {
+            auto idx = static_cast<fastcsum_offload_desc *>(out[i].completion) - descs.data();
+            REQUIRE(!seen[idx]);
+            seen[idx] = true;
+            auto ref = checksum_ref(out[i].ptr, out[i].len, static_cast<uint16_t>(out[i].initial));
+            REQUIRE(ref == fastcsum_fold_complement(out[i].result));
+        }
+        completed += n;
+    }
+    REQUIRE(fastcsum_offload_inflight(q) == 0);
+    fastcsum_offload_destroy(q);
+}
+
+struct packet_batch {
+    std::vector<uint8_t> data;
+    std::vector<const uint8_t *> ptrs;
+    std::vector<size_t> sizes;
+    std::vector<uint64_t> initials;
+};
+
+static packet_batch create_batch(size_t n, size_t minsize, size_t maxsize) {
+    std::default_random_engine rnd(Catch::getSeed());
+    packet_batch batch;
+    batch.data = create_packet(n * (maxsize + 8));
+    for (size_t i = 0; i < n; i++) {
+        batch.ptrs.push_back(&batch.data[i * (maxsize + 8) + rnd() % 8]);
+        batch.sizes.push_back(minsize + rnd() % (maxsize - minsize + 1));
+        batch.initials.push_back(rnd() & 0xffff);
+    }
+    return batch;
+}
+
+TEST_CASE("checksum-batch") {
+    auto n = GENERATE(1, 7, 8, 13, 64, 100);
+    auto batch = create_batch(n, 1, 300);
+    std::vector<uint16_t> refs;
+    for (size_t i = 0; i < batch.ptrs.size(); i++)
+        refs.push_back(checksum_ref(batch.ptrs[i], batch.sizes[i], batch.initials[i]));
+
+    std::vector<uint64_t> out(n);
+    auto check = [&](decltype(fastcsum_nofold_batch) impl) {
+        impl(batch.ptrs.data(), batch.sizes.data(), n, batch.initials.data(), out.data());
+        for (size_t i = 0; i < out.size(); i++)
+            REQUIRE(refs[i] == fastcsum_fold_complement(out[i]));
+    };
+    check(fastcsum_nofold_batch);
+    check(fastcsum_nofold_batch_generic);
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable())
+        check(fastcsum_nofold_batch_avx2);
+#endif
+
+    std::vector<uint16_t> folded(n);
+    fastcsum_batch_fold_complement(batch.ptrs.data(), batch.sizes.data(), n, batch.initials.data(), folded.data());
+    REQUIRE(folded == refs);
+}
+
+TEST_CASE("checksum-batch-verify") {
+    size_t n = 100;
+    auto batch = create_batch(n, 2, 200);
+    for (size_t i = 0; i < n; i++) {
+        auto pkt = const_cast<uint8_t *>(batch.ptrs[i]);
+        pkt[0] = pkt[1] = 0;
+        auto csum = checksum_ref(pkt, batch.sizes[i], 0);
+        if (i % 3 == 0)
+            csum ^= 1;
+        memcpy(pkt, &csum, sizeof(csum));
+    }
+    std::vector<uint64_t> mismatch((n + 63) / 64);
+    REQUIRE(fastcsum_batch_verify(batch.ptrs.data(), batch.sizes.data(), n, nullptr, mismatch.data()) == 34);
+    for (size_t i = 0; i < n; i++)
+        REQUIRE(((mismatch[i / 64] >> (i % 64)) & 1) == (i % 3 == 0));
+}
+
+TEST_CASE("checksum-update") {
+    auto size = GENERATE(Catch::Generators::range(4, 80));
+    auto pkt = create_packet(size);
+    std::default_random_engine rnd(Catch::getSeed());
+    auto csum = checksum_ref(pkt.data(), size, 0);
+
+    size_t off16 = rnd() % (size / 2) * 2;
+    uint16_t old16, new16 = rnd();
+    memcpy(&old16, &pkt[off16], 2);
+    memcpy(&pkt[off16], &new16, 2);
+    auto ref = checksum_ref(pkt.data(), size, 0);
+    REQUIRE(ref == fastcsum_update16(csum, old16, new16));
+    uint16_t batch = csum;
+    fastcsum_update16_batch(&batch, &old16, &new16, 1);
+    REQUIRE(ref == batch);
+    csum = ref;
+
+    size_t off32 = rnd() % (size / 4) * 4;
+    uint32_t old32, new32 = rnd();
+    memcpy(&old32, &pkt[off32], 4);
+    memcpy(&pkt[off32], &new32, 4);
+    ref = checksum_ref(pkt.data(), size, 0);
+    REQUIRE(ref == fastcsum_update32(csum, old32, new32));
+    csum = ref;
+
+    size_t off = rnd() % size;
+    size_t len = 1 + rnd() % (size - off);
+    auto old_bytes = std::vector<uint8_t>(&pkt[off], &pkt[off + len]);
+    fill_random(&pkt[off], len);
+    ref = checksum_ref(pkt.data(), size, 0);
+    REQUIRE(ref == fastcsum_update_range(csum, old_bytes.data(), &pkt[off], len, off));
+}
+
+TEST_CASE("checksum-update-rfc1624") {
+    // RFC 1624 section 3: the other header fields sum to 0xCD7A and m = 0x5555 changes to m' = 0x3285
+    uint16_t hc = ~(0xcd7a + 0x5555 - 0xffff);
+    REQUIRE(hc == 0xdd2f);
+    REQUIRE(fastcsum_update16(hc, 0x5555, 0x3285) == 0x0000);
+    REQUIRE(fastcsum_update16(0x0000, 0x3285, 0x5555) == 0xdd2f);
+}
+
+TEST_CASE("checksum-update-batch") {
+    size_t n = 37;
+    std::default_random_engine rnd(Catch::getSeed());
+    std::vector<uint16_t> csums(n), olds16(n), news16(n), ref16(n), ref32(n);
+    std::vector<uint32_t> olds32(n), news32(n);
+    for (size_t i = 0; i < n; i++) {
+        csums[i] = rnd();
+        olds16[i] = rnd();
+        news16[i] = rnd();
+        olds32[i] = rnd();
+        news32[i] = rnd();
+        ref16[i] = fastcsum_update16(csums[i], olds16[i], news16[i]);
+        ref32[i] = fastcsum_update32(csums[i], olds32[i], news32[i]);
+    }
+    auto out = csums;
+    fastcsum_update16_batch(out.data(), olds16.data(), news16.data(), n);
+    REQUIRE(out == ref16);
+    out = csums;
+    fastcsum_update32_batch(out.data(), olds32.data(), news32.data(), n);
+    REQUIRE(out == ref32);
+
+    auto batch = create_batch(n, 64, 64);
+    std::vector<uint8_t *> pkts;
+    for (auto p : batch.ptrs) {
+        auto pkt = const_cast<uint8_t *>(p);
+        pkt[0] = pkt[1] = 0;
+        auto csum = checksum_ref(pkt, 64, 0);
+        memcpy(pkt, &csum, 2);
+        pkts.push_back(pkt);
+    }
+    fastcsum_rewrite16_batch(pkts.data(), n, 0, 10, news16.data());
+    fastcsum_rewrite32_batch(pkts.data(), n, 0, 20, news32.data());
+    for (auto pkt : pkts)
+        REQUIRE(checksum_ref(pkt, 64, 0) == 0);
+}
+
+TEST_CASE("checksum-template") {
+    auto size = GENERATE(64, 65, 512, 1500);
+    std::vector<size_t> offsets{3, 4, 38, 24, 12, static_cast<size_t>(size - 3)};
+    std::vector<size_t> lens{1, 4, 2, 8, 9, 3};
+    auto tmpl = create_packet(size);
+    fastcsum_template t;
+    REQUIRE(fastcsum_template_init(&t, tmpl.data(), size, offsets.data(), lens.data(), offsets.size()));
+
+    auto pkt = tmpl;
+    for (int i = 0; i < 10; i++) {
+        for (size_t f = 0; f < offsets.size(); f++)
+            fill_random(&pkt[offsets[f]], lens[f] - (i % 2));
+        REQUIRE(checksum_ref(pkt.data(), size, 0) == fastcsum_fold_complement(fastcsum_template_sum(&t, pkt.data())));
+    }
+
+    offsets.push_back(5);
+    lens.push_back(1);
+    REQUIRE(!fastcsum_template_init(&t, tmpl.data(), size, offsets.data(), lens.data(), offsets.size()));
+}
+
+static packet_batch create_ipv4_headers(size_t n, bool options) {
+    std::default_random_engine rnd(Catch::getSeed());
+    auto batch = create_batch(n, 60, 60);
+    for (auto p : batch.ptrs) {
+        auto hdr = const_cast<uint8_t *>(p);
+        hdr[0] = 0x40 | (options ? 5 + rnd() % 11 : 5);
+        hdr[10] = hdr[11] = 0;
+        auto csum = checksum_ref(hdr, (hdr[0] & 0xf) * 4, 0);
+        memcpy(&hdr[10], &csum, 2);
+    }
+    return batch;
+}
+
+TEST_CASE("checksum-ipv4") {
+    auto options = GENERATE(false, true);
+    size_t n = 77;
+    auto batch = create_ipv4_headers(n, options);
+    std::vector<uint8_t *> hdrs;
+    for (size_t i = 0; i < n; i++) {
+        auto hdr = const_cast<uint8_t *>(batch.ptrs[i]);
+        REQUIRE(fastcsum_ipv4_hdr_verify(hdr));
+        if (i % 5 == 0)
+            hdr[8]--;
+        hdrs.push_back(hdr);
+    }
+
+    auto check = [&](decltype(fastcsum_ipv4_hdr_verify_batch) impl) {
+        std::vector<uint64_t> invalid((n + 63) / 64);
+        REQUIRE(impl(batch.ptrs.data(), n, invalid.data()) == 16);
+        for (size_t i = 0; i < n; i++)
+            REQUIRE(((invalid[i / 64] >> (i % 64)) & 1) == (i % 5 == 0));
+    };
+    check(fastcsum_ipv4_hdr_verify_batch);
+    check(fastcsum_ipv4_hdr_verify_batch_generic);
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable())
+        check(fastcsum_ipv4_hdr_verify_batch_avx2);
+#endif
+
+    auto regenerate = [&](decltype(fastcsum_ipv4_hdr_generate_batch) impl) {
+        for (auto hdr : hdrs)
+            hdr[10] ^= 0x5a;
+        impl(hdrs.data(), n);
+        for (auto hdr : hdrs)
+            REQUIRE(checksum_ref(hdr, (hdr[0] & 0xf) * 4, 0) == 0);
+    };
+    regenerate(fastcsum_ipv4_hdr_generate_batch);
+    regenerate(fastcsum_ipv4_hdr_generate_batch_generic);
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable())
+        regenerate(fastcsum_ipv4_hdr_generate_batch_avx2);
+#endif
+}
+
+TEST_CASE("checksum-l4") {
+    auto len = GENERATE(8, 9, 20, 21, 1480, 1481);
+    auto v6 = GENERATE(false, true);
+    auto addrs = create_packet(32);
+    auto l4 = create_packet(len);
+    l4[6] = l4[7] = 0;
+    uint8_t proto = 17;
+
+    std::vector<uint8_t> pseudo;
+    size_t alen = v6 ? 16 : 4;
+    pseudo.insert(pseudo.end(), addrs.begin(), addrs.begin() + 2 * alen);
+    if (v6) {
+        uint32_t len32 = htonl(len);
+        pseudo.insert(pseudo.end(), reinterpret_cast<uint8_t *>(&len32), reinterpret_cast<uint8_t *>(&len32) + 4);
+        pseudo.insert(pseudo.end(), {0, 0, 0, proto});
+    } else {
+        pseudo.insert(pseudo.end(), {0, proto, static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len)});
+    }
+    pseudo.insert(pseudo.end(), l4.begin(), l4.end());
+    auto ref = checksum_ref(pseudo.data(), pseudo.size(), 0);
+
+    auto l4csum = v6 ? fastcsum_l4_v6 : fastcsum_l4_v4;
+    REQUIRE(ref == l4csum(&addrs[0], &addrs[alen], proto, l4.data(), l4.size()));
+    memcpy(&l4[6], &ref, 2);
+    REQUIRE(0 == l4csum(&addrs[0], &addrs[alen], proto, l4.data(), l4.size()));
+}
+
+struct frame_spec {
+    int vlans;
+    bool v6;
+    // IPv4 options or an IPv6 hop-by-hop header
+    bool options;
+    // 6, 17, 136, or 1 for ICMP/ICMPv6
+    uint8_t proto;
+    size_t payload;
+};
+
+static std::vector<uint8_t> build_frame(const frame_spec &spec) {
+    auto rand = create_packet(64 + spec.payload);
+    std::vector<uint8_t> f(rand.begin(), rand.begin() + 12);
+    for (int i = 0; i < spec.vlans; i++)
+        f.insert(f.end(), {static_cast<uint8_t>(i ? 0x81 : 0x88), static_cast<uint8_t>(i ? 0x00 : 0xa8), 0x00, 0x05});
+    f.insert(f.end(), {static_cast<uint8_t>(spec.v6 ? 0x86 : 0x08), static_cast<uint8_t>(spec.v6 ? 0xdd : 0x00)});
+
+    uint8_t proto = spec.proto == 1 && spec.v6 ? 58 : spec.proto;
+    size_t l4_len = (proto == 6 ? 20 : 8) + spec.payload;
+    if (spec.v6) {
+        size_t ext = spec.options ? 8 : 0;
+        auto plen = ext + l4_len;
+        f.insert(f.end(), {0x60, 0, 0, 0, static_cast<uint8_t>(plen >> 8), static_cast<uint8_t>(plen)});
+        f.insert(f.end(), {static_cast<uint8_t>(spec.options ? 0 : proto), 64});
+        f.insert(f.end(), rand.begin() + 12, rand.begin() + 44);
+        if (spec.options)
+            f.insert(f.end(), {proto, 0, 1, 4, 0, 0, 0, 0});
+    } else {
+        uint8_t ihl = spec.options ? 8 : 5;
+        size_t tot = ihl * 4 + l4_len;
+        f.insert(
+            f.end(),
+            {static_cast<uint8_t>(0x40 | ihl), 0, static_cast<uint8_t>(tot >> 8), static_cast<uint8_t>(tot)});
+        f.insert(f.end(), {0x12, 0x34, 0x40, 0x00, 64, proto, 0, 0});
+        f.insert(f.end(), rand.begin() + 12, rand.begin() + 20);
+        f.insert(f.end(), (ihl - 5) * 4, 1);
+    }
+
+    auto l4 = f.size();
+    f.insert(f.end(), rand.begin() + 44, rand.begin() + 44 + l4_len - spec.payload);
+    f.insert(f.end(), rand.begin() + 64, rand.end());
+    f[l4 + (proto == 6 ? 16 : proto == 1 || proto == 58 ? 2 : 6)] = 0;
+    f[l4 + (proto == 6 ? 17 : proto == 1 || proto == 58 ? 3 : 7)] = 0;
+    if (proto == 6) {
+        f[l4 + 12] = 0x50;
+    } else if (proto == 17) {
+        f[l4 + 4] = static_cast<uint8_t>(l4_len >> 8);
+        f[l4 + 5] = static_cast<uint8_t>(l4_len);
+    } else if (proto == 136) {
+        f[l4 + 4] = f[l4 + 5] = 0;
+    }
+    return f;
+}
+
+// Checks the L4 checksum of a frame built by build_frame with the reference implementation.
+static uint16_t frame_l4_ref(const std::vector<uint8_t> &f, const fastcsum_frame_info &info, bool v6) {
+    std::vector<uint8_t> pseudo;
+    auto l3 = &f[info.l3_offset];
+    if (v6) {
+        pseudo.insert(pseudo.end(), l3 + 8, l3 + 40);
+        pseudo.insert(pseudo.end(), {0, 0, static_cast<uint8_t>(info.l4_len >> 8), static_cast<uint8_t>(info.l4_len)});
+        pseudo.insert(pseudo.end(), {0, 0, 0, info.l4_proto});
+    } else if (info.l4_proto != 1) {
+        pseudo.insert(pseudo.end(), l3 + 12, l3 + 20);
+        pseudo.insert(
+            pseudo.end(),
+            {0, info.l4_proto, static_cast<uint8_t>(info.l4_len >> 8), static_cast<uint8_t>(info.l4_len)});
+    }
+    pseudo.insert(pseudo.end(), f.begin() + info.l4_offset, f.begin() + info.l4_offset + info.l4_len);
+    return checksum_ref(pseudo.data(), pseudo.size(), 0);
+}
+
+TEST_CASE("checksum-frame") {
+    auto vlans = GENERATE(0, 2);
+    auto v6 = GENERATE(false, true);
+    auto options = GENERATE(false, true);
+    auto proto = GENERATE(as<uint8_t>{}, 6, 17, 136, 1);
+    auto payload = GENERATE(0, 1, 33, 1400);
+    auto f = build_frame({vlans, v6, options, proto, static_cast<size_t>(payload)});
+
+    fastcsum_frame_info info;
+    auto flags = fastcsum_frame_fill(f.data(), f.size(), &info);
+    REQUIRE((flags & FASTCSUM_FRAME_ERRORS) == 0);
+    REQUIRE((flags & (v6 ? FASTCSUM_FRAME_IPV6 : FASTCSUM_FRAME_IPV4)));
+    REQUIRE(info.l3_offset == 14 + 4 * vlans);
+    REQUIRE(info.l4_offset + info.l4_len == f.size());
+    if (!v6)
+        REQUIRE(checksum_ref(&f[info.l3_offset], info.l4_offset - info.l3_offset, 0) == 0);
+    REQUIRE(frame_l4_ref(f, info, v6) == 0);
+    REQUIRE(fastcsum_frame_verify(f.data(), f.size(), nullptr) == flags);
+
+    f.back() ^= 0x10;
+    REQUIRE(fastcsum_frame_verify(f.data(), f.size(), nullptr) == (flags | FASTCSUM_FRAME_BAD_L4));
+    f.back() ^= 0x10;
+    if (!v6) {
+        f[info.l3_offset + 8]--;
+        REQUIRE(fastcsum_frame_verify(f.data(), f.size(), nullptr) == (flags | FASTCSUM_FRAME_BAD_L3));
+    }
+    REQUIRE(fastcsum_frame_verify(f.data(), f.size() - info.l4_len - 1, nullptr) & FASTCSUM_FRAME_MALFORMED);
+}
+
+TEST_CASE("checksum-frame-batch") {
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < 40; i++)
+        frames.push_back(build_frame({i % 3, i % 2 == 0, i % 5 == 0, static_cast<uint8_t>(i % 4 ? 6 : 17), 100}));
+    std::vector<uint8_t *> ptrs;
+    std::vector<size_t> lens;
+    for (auto &f : frames) {
+        ptrs.push_back(f.data());
+        lens.push_back(f.size());
+    }
+    std::vector<unsigned int> flags(frames.size());
+    fastcsum_frame_fill_batch(ptrs.data(), lens.data(), ptrs.size(), flags.data(), nullptr);
+    for (size_t i = 0; i < frames.size(); i += 7)
+        frames[i][lens[i] - 1]++;
+    std::vector<const uint8_t *> cptrs(ptrs.begin(), ptrs.end());
+    REQUIRE(fastcsum_frame_verify_batch(cptrs.data(), lens.data(), cptrs.size(), flags.data(), nullptr) == 6);
+}
+
+// Wraps a filled-in inner frame into outer Ethernet/IP/UDP and an 8-byte VXLAN header.
+static std::vector<uint8_t> build_encap(bool outer_v6, const std::vector<uint8_t> &inner) {
+    auto f = build_frame({0, outer_v6, false, 17, 8 + inner.size()});
+    fastcsum_frame_info info;
+    fastcsum_frame_fill(f.data(), f.size(), &info);
+    std::copy(inner.begin(), inner.end(), f.end() - inner.size());
+    return f;
+}
+
+TEST_CASE("checksum-lco") {
+    auto outer_v6 = GENERATE(false, true);
+    auto inner_v6 = GENERATE(false, true);
+    auto proto = GENERATE(as<uint8_t>{}, 6, 17, 1);
+    auto payload = GENERATE(0, 1, 1001);
+    auto inner = build_frame({0, inner_v6, true, proto, static_cast<size_t>(payload)});
+    fastcsum_frame_fill(inner.data(), inner.size(), nullptr);
+    auto f = build_encap(outer_v6, inner);
+
+    fastcsum_frame_info info;
+    fastcsum_frame_verify(f.data(), f.size(), &info);
+    f[info.l4_offset + 6] ^= 0xff;
+    REQUIRE(fastcsum_frame_verify(f.data(), f.size(), nullptr) & FASTCSUM_FRAME_BAD_L4);
+
+    size_t inner_l3 = f.size() - inner.size() + 14 - info.l3_offset;
+    REQUIRE(fastcsum_encap_udp_lco(&f[info.l3_offset], f.size() - info.l3_offset, inner_l3) == 0);
+    REQUIRE((fastcsum_frame_verify(f.data(), f.size(), nullptr) & FASTCSUM_FRAME_ERRORS) == 0);
+    REQUIRE(frame_l4_ref(f, info, outer_v6) == 0);
+}
+
+TEST_CASE("checksum-segments") {
+    auto seg_size = GENERATE(1, 7, 64, 537);
+    auto size = GENERATE(0, 1, 1000, 4099);
+    auto pkt = create_packet(size + 1);
+    std::vector<uint64_t> out(size / seg_size + 1);
+    auto n = fastcsum_nofold_segments(pkt.data(), size, seg_size, out.data());
+    REQUIRE(n == (size + seg_size - 1) / seg_size);
+    for (size_t i = 0; i < n; i++) {
+        auto len = std::min<size_t>(seg_size, size - i * seg_size);
+        REQUIRE(checksum_ref(&pkt[i * seg_size], len, 0) == fastcsum_fold_complement(out[i]));
+    }
+}
+
+TEST_CASE("checksum-gso") {
+    auto v6 = GENERATE(false, true);
+    auto mss = GENERATE(536, 537, 1448);
+    auto len = GENERATE(0, 1, 1448, 5001);
+    auto addrs = create_packet(32);
+    auto tcp = create_packet(32);
+    tcp[12] = 0x80;
+    tcp[13] = 0x80 | 0x10 | 0x08 | 0x01;
+    auto payload = create_packet(len + 1);
+    std::vector<uint16_t> csums(len / mss + 1);
+    auto n =
+        fastcsum_gso_tcp(v6, &addrs[0], &addrs[16], tcp.data(), tcp.size(), payload.data(), len, mss, csums.data());
+    REQUIRE(n == std::max<size_t>(1, (len + mss - 1) / mss));
+
+    uint32_t seq0 = ntohl(*reinterpret_cast<u32u *>(&tcp[4]));
+    for (size_t i = 0; i < n; i++) {
+        auto seg_len = std::min<size_t>(mss, len - i * mss);
+        std::vector<uint8_t> seg(tcp);
+        uint32_t seq = htonl(seq0 + i * mss);
+        memcpy(&seg[4], &seq, 4);
+        if (i)
+            seg[13] &= ~0x80;
+        if (i != n - 1)
+            seg[13] &= ~(0x08 | 0x01);
+        seg[16] = seg[17] = 0;
+        seg.insert(seg.end(), &payload[i * mss], &payload[i * mss + seg_len]);
+        auto ref = v6 ? fastcsum_l4_v6(&addrs[0], &addrs[16], 6, seg.data(), seg.size())
+                      : fastcsum_l4_v4(&addrs[0], &addrs[16], 6, seg.data(), seg.size());
+        REQUIRE(ref == csums[i]);
+    }
+}
+
+TEST_CASE("checksum-gro") {
+    auto v6 = GENERATE(false, true);
+    auto nsegs = GENERATE(1, 2, 9);
+    std::default_random_engine rnd(Catch::getSeed());
+    auto addrs = create_packet(32);
+    auto payload = create_packet(nsegs * 1500);
+    auto pseudo = [&](size_t len) {
+        return v6 ? fastcsum_nofold_pseudo_v6(&addrs[0], &addrs[16], 6, len)
+                  : fastcsum_nofold_pseudo_v4(&addrs[0], &addrs[16], 6, len);
+    };
+
+    fastcsum_gro gro{};
+    size_t off = 0;
+    for (int i = 0; i < nsegs; i++) {
+        auto tcp_len = 20 + 4 * (rnd() % 4);
+        auto seg = create_packet(tcp_len);
+        seg[16] = seg[17] = 0;
+        auto seg_len = 1 + rnd() % 1500;
+        seg.insert(seg.end(), &payload[off], &payload[off + seg_len]);
+        auto csum = fastcsum_fold_complement(fastcsum_nofold(seg.data(), seg.size(), pseudo(seg.size())));
+        memcpy(&seg[16], &csum, 2);
+        fastcsum_gro_push(&gro, pseudo(seg.size()), seg.data(), tcp_len, seg_len);
+        off += seg_len;
+    }
+    REQUIRE(gro.payload_len == off);
+
+    auto merged = create_packet(32);
+    merged.insert(merged.end(), &payload[0], &payload[off]);
+    auto csum = fastcsum_gro_finish(&gro, pseudo(merged.size()), merged.data(), 32);
+    merged[16] = merged[17] = 0;
+    auto ref = v6 ? fastcsum_l4_v6(&addrs[0], &addrs[16], 6, merged.data(), merged.size())
+                  : fastcsum_l4_v4(&addrs[0], &addrs[16], 6, merged.data(), merged.size());
+    REQUIRE(ref == csum);
+}
+
+TEST_CASE("checksum-skip") {
+    uint16_t initial = GENERATE(0, 0x1234);
+    auto size = GENERATE(1, 2, 20, 21, 1500);
+    auto nskips = GENERATE(0, 1, 2, 5, 16);
+    std::default_random_engine rnd(Catch::getSeed());
+    auto pkt = create_packet(size);
+    std::vector<size_t> offsets, lens;
+    auto zeroed = pkt;
+    for (int i = 0; i < nskips; i++) {
+        offsets.push_back(rnd() % (size + 2));
+        lens.push_back(rnd() % 9);
+        for (size_t j = offsets.back(); j < offsets.back() + lens.back() && j < static_cast<size_t>(size); j++)
+            zeroed[j] = 0;
+    }
+    auto ref = checksum_ref(zeroed.data(), size, initial);
+    auto ac = fastcsum_nofold_skip(pkt.data(), size, initial, offsets.data(), lens.data(), offsets.size());
+    REQUIRE(ref == fastcsum_fold_complement(ac));
+}
+
+TEST_CASE("checksum-ranges") {
+    auto size = GENERATE(0, 1, 21, 1500);
+    auto nranges = GENERATE(1, 2, 4, 9, 32);
+    std::default_random_engine rnd(Catch::getSeed());
+    auto pkt = create_packet(size);
+    std::vector<size_t> starts, ends;
+    for (int i = 0; i < nranges; i++) {
+        starts.push_back(rnd() % (size + 2));
+        ends.push_back(starts.back() + rnd() % (size + 2));
+    }
+    std::vector<uint64_t> out(nranges);
+    fastcsum_nofold_ranges(pkt.data(), size, starts.data(), ends.data(), nranges, out.data());
+    for (int i = 0; i < nranges; i++) {
+        auto end = std::min(ends[i], static_cast<size_t>(size));
+        auto len = starts[i] < end ? end - starts[i] : 0;
+        REQUIRE(checksum_ref(pkt.data() + std::min(starts[i], end), len, 0) == fastcsum_fold_complement(out[i]));
+    }
+}
+
+TEST_CASE("checksum-blocks") {
+    auto size = GENERATE(0, 1, 511, 512, 4097, 1 << 20, (1 << 20) + 3);
+    auto block_size = GENERATE(1, 100, 512, 4096, 65536);
+    auto buf = create_packet(size);
+    std::vector<uint16_t> out(size / block_size + 1);
+    auto n = fastcsum_blocks(buf.data(), size, block_size, out.data());
+    REQUIRE(n == (size + block_size - 1) / block_size);
+    for (size_t i = 0; i < n; i++) {
+        auto len = std::min<size_t>(block_size, size - i * block_size);
+        REQUIRE(out[i] == checksum_ref(buf.data() + i * block_size, len, 0));
+    }
+
+    std::vector<uint16_t> par(out.size());
+    REQUIRE(fastcsum_blocks_parallel(buf.data(), size, block_size, par.data(), 4) == n);
+    REQUIRE(std::equal(out.begin(), out.begin() + n, par.begin()));
+
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable()) {
+        std::vector<uint16_t> avx2(out.size());
+        REQUIRE(fastcsum_blocks_avx2(buf.data(), size, block_size, avx2.data()) == n);
+        REQUIRE(std::equal(out.begin(), out.begin() + n, avx2.begin()));
+    }
+#endif
+}
+
+TEST_CASE("checksum-index") {
+    auto size = GENERATE(0, 1, 4095, 65536, 100003);
+    size_t leaf_size = GENERATE(1, 64, 1001, 4096);
+    std::default_random_engine rnd(Catch::getSeed());
+    auto buf = create_packet(size);
+    std::unique_ptr<fastcsum_index, decltype(&fastcsum_index_destroy)> idx(
+        fastcsum_index_create(buf.data(), size, leaf_size),
+        fastcsum_index_destroy);
+    REQUIRE(idx);
+    REQUIRE(checksum_ref(buf.data(), size, 0) == fastcsum_fold_complement(fastcsum_index_query(idx.get(), 0, size)));
+
+    for (int round = 0; round < 20 && size; round++) {
+        size_t off = rnd() % size;
+        size_t len = std::min<size_t>(rnd() % 200, size - off);
+        fill_random(buf.data() + off, len);
+        fastcsum_index_update(idx.get(), off, len);
+
+        size_t start = rnd() % size;
+        size_t end = start + rnd() % (size - start + 1);
+        REQUIRE(
+            checksum_ref(buf.data() + start, end - start, 0) ==
+            fastcsum_fold_complement(fastcsum_index_query(idx.get(), start, end)));
+        REQUIRE(
+            checksum_ref(buf.data(), size, 0) == fastcsum_fold_complement(fastcsum_index_query(idx.get(), 0, size)));
+    }
+}
+
+TEST_CASE("checksum-memo") {
+    size_t chunk_size = GENERATE(1, 7, 512);
+    size_t max_entries = GENERATE(1, 16, 4096);
+    std::default_random_engine rnd(Catch::getSeed());
+    std::vector<std::vector<uint8_t>> bufs = {create_packet(65536), create_packet(3001)};
+    std::unique_ptr<fastcsum_memo, decltype(&fastcsum_memo_destroy)> memo(
+        fastcsum_memo_create(chunk_size, max_entries),
+        fastcsum_memo_destroy);
+    REQUIRE(memo);
+
+    for (int round = 0; round < 200; round++) {
+        auto id = rnd() % bufs.size();
+        auto &buf = bufs[id];
+        size_t off = rnd() % buf.size();
+        size_t len = rnd() % std::min<size_t>(buf.size() - off + 1, 3000);
+        if (round % 10 == 9) {
+            fill_random(buf.data() + off, len);
+            fastcsum_memo_invalidate(memo.get(), id, off, len);
+        }
+        REQUIRE(
+            checksum_ref(buf.data() + off, len, 0) ==
+            fastcsum_fold_complement(fastcsum_memo_sum(memo.get(), id, buf.data(), off, len)));
+        REQUIRE(fastcsum_memo_entries(memo.get()) <= max_entries);
+    }
+
+    fastcsum_memo_invalidate(memo.get(), 0, 0, SIZE_MAX);
+    fastcsum_memo_invalidate(memo.get(), 1, 0, SIZE_MAX);
+    REQUIRE(fastcsum_memo_entries(memo.get()) == 0);
+}
+
+TEST_CASE("checksum-frag") {
+    auto size = GENERATE(1, 8, 1481, 65515);
+    size_t frag_size = GENERATE(8, 1480);
+    std::default_random_engine rnd(Catch::getSeed());
+    auto payload = create_packet(size);
+    std::vector<size_t> offsets;
+    for (size_t off = 0; off < static_cast<size_t>(size); off += frag_size)
+        offsets.push_back(off);
+    // deliver in order if there are more fragments than holes can be tracked
+    if (offsets.size() <= FASTCSUM_FRAG_MAX_RANGES)
+        std::shuffle(offsets.begin(), offsets.end(), rnd);
+
+    fastcsum_frag frag{};
+    for (size_t i = 0; i < offsets.size(); i++) {
+        auto off = offsets[i];
+        auto len = std::min<size_t>(frag_size, size - off);
+        bool last = off + len == static_cast<size_t>(size);
+        auto ret = fastcsum_frag_add(&frag, off, payload.data() + off, len, last);
+        REQUIRE(ret == (i + 1 == offsets.size() ? 1 : 0));
+        if (i == 0) {
+            // a duplicate is rejected without touching the state
+            auto copy = frag;
+            REQUIRE(fastcsum_frag_add(&frag, off, payload.data() + off, len, last) == -1);
+            REQUIRE(std::memcmp(&copy, &frag, sizeof(frag)) == 0);
+        }
+    }
+    REQUIRE(checksum_ref(payload.data(), size, 0) == fastcsum_fold_complement(frag.sum));
+
+    fastcsum_frag bad{};
+    REQUIRE(fastcsum_frag_add(&bad, 16, payload.data(), 8, true) == 0);
+    REQUIRE(fastcsum_frag_add(&bad, 24, payload.data(), 8, false) == -1);
+    REQUIRE(fastcsum_frag_add(&bad, 8, payload.data(), 16, false) == -1);
+    REQUIRE(fastcsum_frag_add(&bad, 0, payload.data(), 16, false) == 1);
+}
+
 TEST_CASE("bench", "[!benchmark]") {
     auto size = GENERATE(40, 128, 576, 1500, 2048, 4096, 8192, 16384, 32768, 65535);
     auto pkt = create_packet(size);
@@ -218,7 +920,7 @@ TEST_CASE("bench", "[!benchmark]") {
         return fastcsum_fold_complement(fastcsum_nofold_x64_128b(pkt.data(), pkt.size(), 0));
     };
     BENCHMARK("x64_64b") {
-        return fastcsum_fold_complement(fastcsum_nofold_x64_128b(pkt.data(), pkt.size(), 0));
+        return fastcsum_fold_complement(fastcsum_nofold_x64_64b(pkt.data(), pkt.size(), 0));
     };
     if (fastcsum_adx_usable()) {
         BENCHMARK("adx_v2") {
@@ -334,3 +1036,337 @@ TEST_CASE("bench-unaligned", "[!benchmark]") {
         };
     }
 }
+
+TEST_CASE("bench-parallel", "[!benchmark]") {
+    auto size = GENERATE(16 << 20, 256 << 20);
+    auto affinity = GENERATE(FASTCSUM_AFFINITY_NONE, FASTCSUM_AFFINITY_CPU, FASTCSUM_AFFINITY_NODE);
+    auto pkt = create_packet(64, size);
+    fastcsum_parallel_set_affinity(affinity);
+    unsigned int maxthreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int nthreads = 1; nthreads <= maxthreads; nthreads *= 2) {
+        BENCHMARK("parallel-" + std::to_string(nthreads)) {
+            return fastcsum_fold_complement(fastcsum_nofold_parallel(pkt.get(), size, 0, nthreads));
+        };
+    }
+    fastcsum_parallel_set_affinity(FASTCSUM_AFFINITY_NONE);
+}
+
+TEST_CASE("bench-offload", "[!benchmark]") {
+    auto size = GENERATE(64, 256, 1500, 9000, 65536);
+    constexpr size_t npkts = 256;
+    auto pkts = create_packet(size * npkts);
+    std::vector<fastcsum_offload_desc> descs(npkts), out(npkts);
+    for (size_t i = 0; i < npkts; i++)
+        descs[i] = {&pkts[i * size], static_cast<size_t>(size), 0, 0, nullptr};
+    auto inline_fn = fastcsum_nofold_best();
+    auto q = fastcsum_offload_create(2, npkts, FASTCSUM_AFFINITY_CPU);
+    REQUIRE(q);
+
+    BENCHMARK("inline") {
+        uint64_t ac = 0;
+        for (auto &d : descs)
+            ac += fastcsum_fold_complement(inline_fn(d.ptr, d.len, d.initial));
+        return ac;
+    };
+    BENCHMARK("offload-throughput") {
+        size_t submitted = 0, completed = 0;
+        uint64_t ac = 0;
+        while (completed < npkts) {
+            submitted += fastcsum_offload_submit(q, &descs[submitted], npkts - submitted);
+            auto n = fastcsum_offload_poll(q, out.data(), npkts);
+            for (size_t i = 0; i < n; i++)
+                ac += fastcsum_fold_complement(out[i].result);
+            completed += n;
+        }
+        return ac;
+    };
+    BENCHMARK("offload-latency") {
+        while (!fastcsum_offload_submit(q, &descs[0], 1)) {
+        }
+        while (!fastcsum_offload_poll(q, out.data(), 1)) {
+        }
+        return fastcsum_fold_complement(out[0].result);
+    };
+    fastcsum_offload_destroy(q);
+}
+
+TEST_CASE("bench-batch", "[!benchmark]") {
+    auto n = GENERATE(32, 256);
+    auto batch = create_batch(n, 40, 200);
+    std::vector<uint64_t> out(n);
+    BENCHMARK("per-packet") {
+        auto fn = fastcsum_nofold_best();
+        for (size_t i = 0; i < batch.ptrs.size(); i++)
+            out[i] = fn(batch.ptrs[i], batch.sizes[i], 0);
+        return out[0];
+    };
+    BENCHMARK("batch_generic") {
+        fastcsum_nofold_batch_generic(batch.ptrs.data(), batch.sizes.data(), n, nullptr, out.data());
+        return out[0];
+    };
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable()) {
+        BENCHMARK("batch_avx2") {
+            fastcsum_nofold_batch_avx2(batch.ptrs.data(), batch.sizes.data(), n, nullptr, out.data());
+            return out[0];
+        };
+    }
+#endif
+}
+
+TEST_CASE("bench-template", "[!benchmark]") {
+    auto size = GENERATE(64, 512, 1500);
+    // ports, sequence number, length and timestamp
+    std::vector<size_t> offsets{0, 4, 12, 16};
+    std::vector<size_t> lens{4, 4, 2, 8};
+    auto pkt = create_packet(size);
+    fastcsum_template t;
+    REQUIRE(fastcsum_template_init(&t, pkt.data(), size, offsets.data(), lens.data(), offsets.size()));
+    uint32_t seq = 0;
+#if defined(__x86_64__)
+    if (fastcsum_adx_usable()) {
+        BENCHMARK("adx_v2") {
+            memcpy(&pkt[4], &++seq, sizeof(seq));
+            return fastcsum_fold_complement(fastcsum_nofold_adx_v2(pkt.data(), pkt.size(), 0));
+        };
+    }
+#endif
+    BENCHMARK("template") {
+        memcpy(&pkt[4], &++seq, sizeof(seq));
+        return fastcsum_fold_complement(fastcsum_template_sum(&t, pkt.data()));
+    };
+}
+
+TEST_CASE("bench-ipv4", "[!benchmark]") {
+    size_t n = 256;
+    auto batch = create_ipv4_headers(n, false);
+    std::vector<uint64_t> invalid((n + 63) / 64);
+    BENCHMARK("generic64") {
+        size_t bad = 0;
+        for (auto hdr : batch.ptrs)
+            bad += fastcsum_fold_complement(fastcsum_nofold_generic64(hdr, 20, 0)) != 0;
+        return bad;
+    };
+    BENCHMARK("verify_batch_generic") {
+        return fastcsum_ipv4_hdr_verify_batch_generic(batch.ptrs.data(), n, invalid.data());
+    };
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable()) {
+        BENCHMARK("verify_batch_avx2") {
+            return fastcsum_ipv4_hdr_verify_batch_avx2(batch.ptrs.data(), n, invalid.data());
+        };
+    }
+#endif
+}
+
+TEST_CASE("bench-frame", "[!benchmark]") {
+    // a rough mix of TCP ACKs, full-sized TCP segments, DNS-sized UDP and QUIC-sized UDP, partly VLAN-tagged and IPv6
+    std::vector<frame_spec> mix{
+        {0, false, false, 6, 0},
+        {0, false, false, 6, 1448},
+        {1, false, false, 6, 1448},
+        {0, true, false, 6, 0},
+        {0, true, false, 6, 1428},
+        {0, false, false, 17, 60},
+        {1, true, false, 17, 1200},
+        {0, false, true, 1, 56},
+    };
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < 256; i++)
+        frames.push_back(build_frame(mix[i * 7 % mix.size()]));
+    std::vector<uint8_t *> ptrs;
+    std::vector<size_t> lens;
+    for (auto &f : frames) {
+        ptrs.push_back(f.data());
+        lens.push_back(f.size());
+    }
+    std::vector<unsigned int> flags(frames.size());
+    fastcsum_frame_fill_batch(ptrs.data(), lens.data(), ptrs.size(), flags.data(), nullptr);
+    std::vector<const uint8_t *> cptrs(ptrs.begin(), ptrs.end());
+
+    BENCHMARK("verify_batch") {
+        return fastcsum_frame_verify_batch(cptrs.data(), lens.data(), cptrs.size(), flags.data(), nullptr);
+    };
+    BENCHMARK("fill_batch") {
+        fastcsum_frame_fill_batch(ptrs.data(), lens.data(), ptrs.size(), flags.data(), nullptr);
+        return flags[0];
+    };
+}
+
+TEST_CASE("bench-lco", "[!benchmark]") {
+    auto payload = GENERATE(64, 1400, 8900);
+    auto inner = build_frame({0, false, false, 6, static_cast<size_t>(payload)});
+    fastcsum_frame_fill(inner.data(), inner.size(), nullptr);
+    auto f = build_encap(false, inner);
+    size_t l3 = 14;
+    size_t inner_l3 = f.size() - inner.size() + 14 - l3;
+    BENCHMARK("full") {
+        f[l3 + 28 + 6] = f[l3 + 28 + 7] = 0;
+        return fastcsum_l4_v4(&f[l3 + 12], &f[l3 + 16], 17, &f[l3 + 20], f.size() - l3 - 20);
+    };
+    BENCHMARK("lco") {
+        return fastcsum_encap_udp_lco(&f[l3], f.size() - l3, inner_l3);
+    };
+}
+
+TEST_CASE("bench-gso", "[!benchmark]") {
+    auto mss = GENERATE(536, 1448, 8948);
+    size_t len = 65536 - 52;
+    auto addrs = create_packet(32);
+    auto tcp = create_packet(32);
+    auto payload = create_packet(len);
+    std::vector<uint16_t> csums(len / mss + 1);
+    BENCHMARK("per-segment") {
+        std::vector<uint8_t> seg(tcp.size() + mss);
+        size_t n = 0;
+        for (size_t off = 0; off < len; off += mss) {
+            auto todo = std::min<size_t>(mss, len - off);
+            memcpy(seg.data(), tcp.data(), tcp.size());
+            memcpy(&seg[tcp.size()], &payload[off], todo);
+            csums[n++] = fastcsum_l4_v4(&addrs[0], &addrs[4], 6, seg.data(), tcp.size() + todo);
+        }
+        return n;
+    };
+    BENCHMARK("gso_tcp") {
+        return fastcsum_gso_tcp(
+            false,
+            &addrs[0],
+            &addrs[4],
+            tcp.data(),
+            tcp.size(),
+            payload.data(),
+            len,
+            mss,
+            csums.data());
+    };
+}
+
+TEST_CASE("bench-gro", "[!benchmark]") {
+    size_t nsegs = 44, seg_len = 1448;
+    auto addrs = create_packet(32);
+    auto merged = create_packet(32 + nsegs * seg_len);
+    auto hdr = create_packet(32);
+    auto pseudo = fastcsum_nofold_pseudo_v4(&addrs[0], &addrs[4], 6, 32 + seg_len);
+    auto merged_pseudo = fastcsum_nofold_pseudo_v4(&addrs[0], &addrs[4], 6, merged.size());
+    BENCHMARK("full") {
+        return fastcsum_l4_v4(&addrs[0], &addrs[4], 6, merged.data(), merged.size());
+    };
+    BENCHMARK("gro") {
+        fastcsum_gro gro{};
+        for (size_t i = 0; i < nsegs; i++)
+            fastcsum_gro_push(&gro, pseudo, hdr.data(), hdr.size(), seg_len);
+        return fastcsum_gro_finish(&gro, merged_pseudo, merged.data(), 32);
+    };
+}
+
+TEST_CASE("bench-ranges", "[!benchmark]") {
+    // outer IPv4 header, outer UDP, inner IPv4 header, inner TCP of a VXLAN frame
+    size_t size = GENERATE(1514, 9014);
+    auto frame = create_packet(size);
+    std::array<size_t, 4> starts = {14, 34, 64, 84};
+    std::array<size_t, 4> ends = {34, size, 84, size};
+    std::array<uint64_t, 4> out;
+    BENCHMARK("separate") {
+        for (size_t i = 0; i < starts.size(); i++)
+            out[i] = fastcsum_nofold(frame.data() + starts[i], ends[i] - starts[i], 0);
+        return out;
+    };
+    BENCHMARK("ranges") {
+        fastcsum_nofold_ranges(frame.data(), frame.size(), starts.data(), ends.data(), starts.size(), out.data());
+        return out;
+    };
+}
+
+TEST_CASE("bench-blocks", "[!benchmark]") {
+    size_t size = 64 << 20;
+    auto block_size = GENERATE(128, 512, 4096, 65536);
+    auto buf = create_packet(size);
+    std::vector<uint16_t> out(size / block_size);
+    BENCHMARK("loop-best") {
+        auto fn = fastcsum_nofold_best();
+        for (size_t i = 0; i < out.size(); i++)
+            out[i] = fastcsum_fold_complement(fn(buf.data() + i * block_size, block_size, 0));
+        return out[0];
+    };
+#if defined(__x86_64__)
+    if (fastcsum_avx2_usable()) {
+        BENCHMARK("loop-avx2_v7") {
+            for (size_t i = 0; i < out.size(); i++)
+                out[i] = fastcsum_fold_complement(fastcsum_nofold_avx2_v7(buf.data() + i * block_size, block_size, 0));
+            return out[0];
+        };
+    }
+#endif
+    BENCHMARK("blocks") {
+        fastcsum_blocks(buf.data(), size, block_size, out.data());
+        return out[0];
+    };
+    BENCHMARK("blocks-parallel") {
+        fastcsum_blocks_parallel(buf.data(), size, block_size, out.data(), 0);
+        return out[0];
+    };
+}
+
+TEST_CASE("bench-index", "[!benchmark]") {
+    size_t size = 256 << 20;
+    auto buf = create_packet(size);
+    std::unique_ptr<fastcsum_index, decltype(&fastcsum_index_destroy)> idx(
+        fastcsum_index_create(buf.data(), size, 4096),
+        fastcsum_index_destroy);
+    std::default_random_engine rnd(1);
+    BENCHMARK("rescan") {
+        size_t off = rnd() % (size - 64);
+        buf[off]++;
+        return fastcsum_nofold(buf.data(), size, 0);
+    };
+    BENCHMARK("index") {
+        size_t off = rnd() % (size - 64);
+        buf[off]++;
+        fastcsum_index_update(idx.get(), off, 64);
+        return fastcsum_index_query(idx.get(), 0, size);
+    };
+}
+
+TEST_CASE("bench-memo", "[!benchmark]") {
+    // retransmitting 64 KiB TSO segments at shifting offsets of a 4 MiB send buffer
+    size_t size = 4 << 20, seg = 65536;
+    auto buf = create_packet(size);
+    std::unique_ptr<fastcsum_memo, decltype(&fastcsum_memo_destroy)> memo(
+        fastcsum_memo_create(2048, size / 2048),
+        fastcsum_memo_destroy);
+    std::default_random_engine rnd(1);
+    BENCHMARK("nofold") {
+        size_t off = rnd() % (size - seg);
+        return fastcsum_nofold(buf.data() + off, seg, 0);
+    };
+    BENCHMARK("memo") {
+        size_t off = rnd() % (size - seg);
+        return fastcsum_memo_sum(memo.get(), 0, buf.data(), off, seg);
+    };
+}
+
+TEST_CASE("bench-frag", "[!benchmark]") {
+    // a 64 KiB UDP datagram in 1480-byte fragments delivered in reverse
+    size_t size = 65515, frag_size = 1480;
+    auto payload = create_packet(size);
+    std::vector<uint8_t> reassembled(size);
+    BENCHMARK("copy-then-sum") {
+        for (size_t off = size / frag_size * frag_size;; off -= frag_size) {
+            std::memcpy(&reassembled[off], &payload[off], std::min(frag_size, size - off));
+            if (!off)
+                break;
+        }
+        return fastcsum_nofold(reassembled.data(), size, 0);
+    };
+    BENCHMARK("accumulate") {
+        fastcsum_frag frag{};
+        for (size_t off = size / frag_size * frag_size;; off -= frag_size) {
+            auto len = std::min(frag_size, size - off);
+            std::memcpy(&reassembled[off], &payload[off], len);
+            fastcsum_frag_add(&frag, off, &payload[off], len, off + len == size);
+            if (!off)
+                break;
+        }
+        return frag.sum;
+    };
+}
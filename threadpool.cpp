@@ -0,0 +1,189 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sched.h>
+#include <pthread.h>
+
+#include "threadpool.hpp"
+
+static constexpr unsigned int max_pool_threads = 256;
+
+static std::vector<unsigned int> parse_cpulist(const char *s) {
+    std::vector<unsigned int> cpus;
+    while (*s) {
+        char *end;
+        unsigned long first = strtoul(s, &end, 10);
+        if (end == s)
+            break;
+        unsigned long last = first;
+        if (*end == '-')
+            last = strtoul(end + 1, &end, 10);
+        for (auto cpu = first; cpu <= last; cpu++)
+            cpus.push_back(static_cast<unsigned int>(cpu));
+        s = end;
+        if (*s == ',')
+            s++;
+    }
+    return cpus;
+}
+
+static std::vector<std::vector<unsigned int>> numa_nodes(const cpu_set_t &allowed) {
+    std::vector<std::vector<unsigned int>> nodes;
+    for (unsigned int node = 0; node < 1024; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", node);
+        auto f = fopen(path, "r");
+        if (!f) {
+            if (node)
+                break;
+            continue;
+        }
+        char buf[4096];
+        std::vector<unsigned int> cpus;
+        if (fgets(buf, sizeof(buf), f)) {
+            for (auto cpu : parse_cpulist(buf))
+                if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                    cpus.push_back(cpu);
+        }
+        fclose(f);
+        if (!cpus.empty())
+            nodes.push_back(std::move(cpus));
+    }
+    return nodes;
+}
+
+void pin_thread(fastcsum_affinity affinity, unsigned int index) {
+    if (affinity == FASTCSUM_AFFINITY_NONE)
+        return;
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed))
+        return;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (affinity == FASTCSUM_AFFINITY_CPU) {
+        std::vector<unsigned int> cpus;
+        for (unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+        if (cpus.empty())
+            return;
+        CPU_SET(cpus[index % cpus.size()], &set);
+    } else {
+        auto nodes = numa_nodes(allowed);
+        if (nodes.empty())
+            return;
+        for (auto cpu : nodes[index % nodes.size()])
+            CPU_SET(cpu, &set);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+thread_pool::thread_pool(unsigned int nworkers, fastcsum_affinity aff) : affinity(aff) {
+    try {
+        threads.reserve(nworkers);
+        for (unsigned int i = 0; i < nworkers; i++)
+            threads.emplace_back(&thread_pool::worker_main, this, i + 1);
+    } catch (...) {
+        // joinable threads must not be destroyed: stop and join those that started before failing
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        start_cv.notify_all();
+        for (auto &t : threads)
+            t.join();
+        throw;
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto &t : threads)
+        t.join();
+}
+
+void thread_pool::run(unsigned int ntasks, const std::function<void(unsigned int)> &fn) {
+    if (!ntasks)
+        return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &fn;
+        job_tasks = ntasks;
+        pending = ntasks - 1;
+        generation++;
+    }
+    if (ntasks > 1)
+        start_cv.notify_all();
+
+    fn(0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    done_cv.wait(guard, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void thread_pool::worker_main(unsigned int index) {
+    pin_thread(affinity, index);
+
+    unsigned long seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        start_cv.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        seen = generation;
+        if (index >= job_tasks)
+            continue;
+
+        auto fn = job;
+        guard.unlock();
+        (*fn)(index);
+        guard.lock();
+        if (--pending == 0)
+            done_cv.notify_one();
+    }
+}
+
+static std::mutex shared_lock;
+static std::unique_ptr<thread_pool> shared_pool;
+static fastcsum_affinity shared_affinity = FASTCSUM_AFFINITY_NONE;
+
+unsigned int shared_pool_threads(unsigned int nthreads) {
+    if (!nthreads)
+        nthreads = std::thread::hardware_concurrency();
+    if (!nthreads)
+        nthreads = 1;
+    if (nthreads > max_pool_threads)
+        nthreads = max_pool_threads;
+    return nthreads;
+}
+
+void shared_pool_run(unsigned int ntasks, const std::function<void(unsigned int)> &fn) {
+    std::lock_guard<std::mutex> guard(shared_lock);
+    if (ntasks > 1 && (!shared_pool || shared_pool->workers() < ntasks - 1)) {
+        shared_pool.reset();
+        try {
+            shared_pool.reset(new thread_pool(ntasks - 1, shared_affinity));
+        } catch (...) {
+            // out of threads or memory: the tasks still run, one after the other on this thread
+        }
+    }
+    if (shared_pool) {
+        shared_pool->run(ntasks, fn);
+    } else {
+        for (unsigned int i = 0; i < ntasks; i++)
+            fn(i);
+    }
+}
+
+extern "C" void fastcsum_parallel_set_affinity(enum fastcsum_affinity affinity) {
+    std::lock_guard<std::mutex> guard(shared_lock);
+    shared_affinity = affinity;
+    shared_pool.reset();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fastcsum.h"
+
+// Pins the calling thread as worker `index` (0 being the thread that submits work).
+void pin_thread(fastcsum_affinity affinity, unsigned int index);
+
+class thread_pool {
+public:
+    thread_pool(unsigned int nworkers, fastcsum_affinity affinity);
+    ~thread_pool();
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    // Runs fn(0) ... fn(ntasks - 1) and waits for completion. Task 0 runs on the calling thread.
+    // Requires ntasks <= workers() + 1.
+    void run(unsigned int ntasks, const std::function<void(unsigned int)> &fn);
+
+    unsigned int workers() const {
+        return static_cast<unsigned int>(threads.size());
+    }
+
+private:
+    void worker_main(unsigned int index);
+
+    fastcsum_affinity affinity;
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    const std::function<void(unsigned int)> *job = nullptr;
+    unsigned int job_tasks = 0;
+    unsigned int pending = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+};
+
+// Runs fn(0) ... fn(ntasks - 1) on a process-wide pool, growing it as needed, or inline if no threads can be
+// started. Concurrent calls are serialized.
+void shared_pool_run(unsigned int ntasks, const std::function<void(unsigned int)> &fn);
+
+// Returns the number of tasks that shared_pool_run should split work into for a request of `nthreads`.
+unsigned int shared_pool_threads(unsigned int nthreads);
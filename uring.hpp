@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Minimal io_uring wrapper on the raw system calls, so that tools do not need liburing. Single-threaded use only.
+class uring {
+public:
+    uring() = default;
+    uring(const uring &) = delete;
+    uring &operator=(const uring &) = delete;
+
+    ~uring() {
+        if (sqes)
+            munmap(sqes, sqes_size);
+        if (cq_ptr && cq_ptr != sq_ptr)
+            munmap(cq_ptr, cq_size);
+        if (sq_ptr)
+            munmap(sq_ptr, sq_size);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    // Returns false with errno set if io_uring is unavailable (old kernel, seccomp, io_uring_disabled...).
+    bool init(unsigned int entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0)
+            return false;
+
+        sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+        cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+            sq_size = cq_size = sq_size > cq_size ? sq_size : cq_size;
+        sq_ptr = map(sq_size, IORING_OFF_SQ_RING);
+        if (!sq_ptr)
+            return false;
+        cq_ptr = single ? sq_ptr : map(cq_size, IORING_OFF_CQ_RING);
+        if (!cq_ptr)
+            return false;
+        sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(map(sqes_size, IORING_OFF_SQES));
+        if (!sqes)
+            return false;
+
+        auto sq = static_cast<uint8_t *>(sq_ptr);
+        sq_head = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        sq_entries = p.sq_entries;
+        auto cq = static_cast<uint8_t *>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    // Queues a vectored read without submitting it. `iov` must stay valid until completion. Returns false if full.
+    bool queue_readv(int file, const iovec *iov, unsigned int niov, uint64_t offset, uint64_t user_data) {
+        auto tail = *sq_tail;
+        if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+            return false;
+        auto idx = tail & sq_mask;
+        auto sqe = &sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = file;
+        sqe->addr = reinterpret_cast<uint64_t>(iov);
+        sqe->len = niov;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+        sq_array[idx] = idx;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        to_submit++;
+        return true;
+    }
+
+    /*
+     * Submits queued requests and waits for at least `wait_nr` completions, or fewer if the kernel is out of resources
+     * while some are ready to pop. Returns false with errno set on failure.
+     */
+    bool submit(unsigned int wait_nr) {
+        while (true) {
+            auto ret = syscall(
+                __NR_io_uring_enter,
+                fd,
+                to_submit,
+                wait_nr,
+                wait_nr ? IORING_ENTER_GETEVENTS : 0,
+                nullptr,
+                0);
+            if (ret >= 0) {
+                to_submit -= static_cast<unsigned int>(ret);
+                return true;
+            }
+            // out of kernel resources or completions backed up: let the caller reap what is ready, or try again
+            if (errno == EAGAIN || errno == EBUSY) {
+                if (*cq_head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+                    return true;
+                sched_yield();
+            } else if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    // Pops one completion if available.
+    bool pop(io_uring_cqe &out) {
+        auto head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+            return false;
+        out = cqes[head & cq_mask];
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    void *map(size_t size, off_t offset) {
+        auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    int fd = -1;
+    void *sq_ptr = nullptr;
+    void *cq_ptr = nullptr;
+    size_t sq_size = 0;
+    size_t cq_size = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqes_size = 0;
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe *cqes = nullptr;
+    unsigned int to_submit = 0;
+};
@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include <immintrin.h>
+
+#include "fastcsum.h"
+#include "addc.hpp"
+
+#if !FASTCSUM_ENABLE_AVX2
+
+extern "C" void fastcsum_nofold_batch_avx2(
+    [[maybe_unused]] const uint8_t *const ptrs[],
+    [[maybe_unused]] const size_t sizes[],
+    [[maybe_unused]] size_t n,
+    [[maybe_unused]] const uint64_t initials[],
+    [[maybe_unused]] uint64_t out[]) {
+    abort();
+}
+
+#else
+
+// Each lane keeps separate sums of the low and high dwords of its qwords, so no carries are lost.
+static inline void add_qwords(__m256i &lo, __m256i &hi, __m256i v) {
+    lo = _mm256_add_epi64(lo, _mm256_and_si256(v, _mm256_set1_epi64x(0xffffffff)));
+    hi = _mm256_add_epi64(hi, _mm256_srli_epi64(v, 32));
+}
+
+static inline void finish_lanes(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    const uint64_t initials[],
+    uint64_t out[],
+    __m256i lo,
+    __m256i hi) {
+    uint64_t los[4], his[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i_u *>(los), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i_u *>(his), hi);
+    for (size_t j = 0; j < 4; j++) {
+        // 2^32 == 1 in 1's complement arithmetic mod 2^16 - 1
+        auto ac = fastcsum_add(los[j], his[j]);
+        ac = csum_31bytes(ptrs[j] + (sizes[j] & ~size_t(7)), sizes[j] & 7, ac);
+        out[j] = initials ? fastcsum_add(ac, initials[j]) : ac;
+    }
+}
+
+extern "C" void fastcsum_nofold_batch_avx2(
+    const uint8_t *const ptrs[],
+    const size_t sizes[],
+    size_t n,
+    const uint64_t initials[],
+    uint64_t out[]) {
+    const __m256i eight = _mm256_set1_epi64x(8);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        // gather indices are relative to the first packet of the group
+        auto base = reinterpret_cast<const long long *>(ptrs[i]);
+        auto vbase = _mm256_set1_epi64x(reinterpret_cast<long long>(base));
+        auto idx1 = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i_u *>(&ptrs[i])), vbase);
+        auto idx2 = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i_u *>(&ptrs[i + 4])), vbase);
+        auto size1 = _mm256_loadu_si256(reinterpret_cast<const __m256i_u *>(&sizes[i]));
+        auto size2 = _mm256_loadu_si256(reinterpret_cast<const __m256i_u *>(&sizes[i + 4]));
+
+        size_t maxsize = 0;
+        for (size_t j = 0; j < 8; j++)
+            if (sizes[i + j] > maxsize)
+                maxsize = sizes[i + j];
+
+        __m256i lo1 = _mm256_setzero_si256(), hi1 = _mm256_setzero_si256();
+        __m256i lo2 = _mm256_setzero_si256(), hi2 = _mm256_setzero_si256();
+        // a lane is active while it has at least 8 bytes left, i.e. size > offset + 7
+        auto limit = _mm256_set1_epi64x(7);
+        for (size_t off = 0; off + 8 <= maxsize; off += 8) {
+            auto m1 = _mm256_cmpgt_epi64(size1, limit);
+            auto m2 = _mm256_cmpgt_epi64(size2, limit);
+            auto v1 = _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), base, idx1, m1, 1);
+            auto v2 = _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), base, idx2, m2, 1);
+            add_qwords(lo1, hi1, v1);
+            add_qwords(lo2, hi2, v2);
+            idx1 = _mm256_add_epi64(idx1, eight);
+            idx2 = _mm256_add_epi64(idx2, eight);
+            limit = _mm256_add_epi64(limit, eight);
+        }
+
+        finish_lanes(&ptrs[i], &sizes[i], initials ? &initials[i] : nullptr, &out[i], lo1, hi1);
+        finish_lanes(&ptrs[i + 4], &sizes[i + 4], initials ? &initials[i + 4] : nullptr, &out[i + 4], lo2, hi2);
+    }
+
+    if (i < n)
+        fastcsum_nofold_batch_generic(&ptrs[i], &sizes[i], n - i, initials ? &initials[i] : nullptr, &out[i]);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include <cstdlib>
+#include <immintrin.h>
+
+#include "fastcsum.h"
+#include "addc.hpp"
+
+#if !FASTCSUM_ENABLE_AVX2
+
+extern "C" size_t fastcsum_blocks_avx2(
+    [[maybe_unused]] const uint8_t *ptr,
+    [[maybe_unused]] size_t size,
+    [[maybe_unused]] size_t block_size,
+    [[maybe_unused]] uint16_t out[]) {
+    abort();
+}
+
+#else
+
+// Lane sums gain less than 2^35 per 128 bytes, so they are flushed well before they could wrap.
+static constexpr size_t flush_bytes = size_t(1) << 32;
+
+// Each lane keeps separate sums of the low and high dwords of its qwords, so no carries are lost.
+static inline void add_qwords(__m256i &lo, __m256i &hi, const uint8_t *b) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i_u *>(b));
+    lo = _mm256_add_epi64(lo, _mm256_and_si256(v, _mm256_set1_epi64x(0xffffffff)));
+    hi = _mm256_add_epi64(hi, _mm256_srli_epi64(v, 32));
+}
+
+// Sums the whole 32-byte units of [b, b + len) and advances `b` past them.
+static inline uint64_t sum_units(const uint8_t *&b, size_t len, uint64_t ac) {
+    __m256i lo1 = _mm256_setzero_si256(), hi1 = _mm256_setzero_si256();
+    __m256i lo2 = _mm256_setzero_si256(), hi2 = _mm256_setzero_si256();
+    __m256i lo3 = _mm256_setzero_si256(), hi3 = _mm256_setzero_si256();
+    __m256i lo4 = _mm256_setzero_si256(), hi4 = _mm256_setzero_si256();
+    for (; len >= 128; len -= 128, b += 128) {
+        add_qwords(lo1, hi1, b);
+        add_qwords(lo2, hi2, b + 32);
+        add_qwords(lo3, hi3, b + 64);
+        add_qwords(lo4, hi4, b + 96);
+    }
+    for (; len >= 32; len -= 32, b += 32)
+        add_qwords(lo1, hi1, b);
+    // 2^32 == 1 in 1's complement arithmetic mod 2^16 - 1
+    auto lo = _mm256_add_epi64(_mm256_add_epi64(lo1, lo2), _mm256_add_epi64(lo3, lo4));
+    auto hi = _mm256_add_epi64(_mm256_add_epi64(hi1, hi2), _mm256_add_epi64(hi3, hi4));
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i_u *>(lanes), _mm256_add_epi64(lo, hi));
+    return fastcsum_add(ac, fastcsum_add(fastcsum_add(lanes[0], lanes[1]), fastcsum_add(lanes[2], lanes[3])));
+}
+
+extern "C" size_t fastcsum_blocks_avx2(const uint8_t *ptr, size_t size, size_t block_size, uint16_t out[]) {
+    if (!block_size)
+        return 0;
+    size_t n = 0;
+    while (size) {
+        size_t left = size < block_size ? size : block_size;
+        auto b = ptr;
+        ptr += left;
+        size -= left;
+
+        // only the accumulators restart at a block boundary, not the whole kernel
+        uint64_t ac = 0;
+        do {
+            size_t run = left < flush_bytes ? left : flush_bytes;
+            ac = sum_units(b, run, ac);
+            left -= run & ~size_t(31);
+        } while (left >= 32);
+        out[n++] = fastcsum_fold_complement(csum_31bytes(b, left, ac));
+    }
+    return n;
+}
+
+#endif
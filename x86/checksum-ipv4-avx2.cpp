@@ -0,0 +1,132 @@
+#include <cstdlib>
+#include <immintrin.h>
+
+#include "fastcsum-net.h"
+#include "addc.hpp"
+
+#if !FASTCSUM_ENABLE_AVX2
+
+extern "C" size_t fastcsum_ipv4_hdr_verify_batch_avx2(
+    [[maybe_unused]] const uint8_t *const hdrs[],
+    [[maybe_unused]] size_t n,
+    [[maybe_unused]] uint64_t invalid[]) {
+    abort();
+}
+
+extern "C" void fastcsum_ipv4_hdr_generate_batch_avx2(
+    [[maybe_unused]] uint8_t *const hdrs[],
+    [[maybe_unused]] size_t n) {
+    abort();
+}
+
+#else
+
+static inline __m256i load_pair(const uint8_t *lo, const uint8_t *hi) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i_u *>(lo))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i_u *>(hi)),
+        1);
+}
+
+static inline __m256i sum_halves(__m256i v) {
+    return _mm256_add_epi32(_mm256_and_si256(v, _mm256_set1_epi32(0xffff)), _mm256_srli_epi32(v, 16));
+}
+
+/*
+ * Transposes 8 IHL=5 headers so that lane j holds header j, and sums their 16-bit words into 32-bit lanes.
+ * The checksum field is left out of the sum if `skip_csum` is set.
+ * Returns the folded sums; `dword0` receives the first dword of each header.
+ */
+static inline __m256i sum_headers(const uint8_t *const h[8], bool skip_csum, __m256i &dword0) {
+    auto a = load_pair(h[0], h[4]);
+    auto b = load_pair(h[1], h[5]);
+    auto c = load_pair(h[2], h[6]);
+    auto d = load_pair(h[3], h[7]);
+    auto t0 = _mm256_unpacklo_epi32(a, b);
+    auto t1 = _mm256_unpackhi_epi32(a, b);
+    auto t2 = _mm256_unpacklo_epi32(c, d);
+    auto t3 = _mm256_unpackhi_epi32(c, d);
+    // lanes are ordered 0 1 2 3 4 5 6 7 after the transpose
+    auto d0 = _mm256_unpacklo_epi64(t0, t2);
+    auto d1 = _mm256_unpackhi_epi64(t0, t2);
+    auto d2 = _mm256_unpacklo_epi64(t1, t3);
+    auto d3 = _mm256_unpackhi_epi64(t1, t3);
+    auto d4 = _mm256_setr_epi32(
+        *reinterpret_cast<const u32u *>(h[0] + 16),
+        *reinterpret_cast<const u32u *>(h[1] + 16),
+        *reinterpret_cast<const u32u *>(h[2] + 16),
+        *reinterpret_cast<const u32u *>(h[3] + 16),
+        *reinterpret_cast<const u32u *>(h[4] + 16),
+        *reinterpret_cast<const u32u *>(h[5] + 16),
+        *reinterpret_cast<const u32u *>(h[6] + 16),
+        *reinterpret_cast<const u32u *>(h[7] + 16));
+    dword0 = d0;
+
+    // the checksum is at bytes 10-11, the upper half of dword 2
+    if (skip_csum)
+        d2 = _mm256_and_si256(d2, _mm256_set1_epi32(0xffff));
+
+    // 10 words of at most 0xffff each fit in a 32-bit lane
+    auto s = _mm256_add_epi32(sum_halves(d0), sum_halves(d1));
+    s = _mm256_add_epi32(s, sum_halves(d2));
+    s = _mm256_add_epi32(s, sum_halves(d3));
+    s = _mm256_add_epi32(s, sum_halves(d4));
+    s = sum_halves(s);
+    s = sum_halves(s);
+    return s;
+}
+
+static inline unsigned int ihl5_lanes(__m256i dword0) {
+    auto ihl = _mm256_and_si256(dword0, _mm256_set1_epi32(0xf));
+    auto eq = _mm256_cmpeq_epi32(ihl, _mm256_set1_epi32(5));
+    return static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+}
+
+extern "C" size_t fastcsum_ipv4_hdr_verify_batch_avx2(const uint8_t *const hdrs[], size_t n, uint64_t invalid[]) {
+    size_t bad = 0;
+    for (size_t i = 0; i < n; i += 64) {
+        uint64_t word = 0;
+        size_t j = 0;
+        for (; j + 8 <= 64 && i + j + 8 <= n; j += 8) {
+            __m256i dword0;
+            auto s = sum_headers(&hdrs[i + j], false, dword0);
+            auto ok = _mm256_cmpeq_epi32(s, _mm256_set1_epi32(0xffff));
+            auto okmask = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(ok)));
+            auto fast = ihl5_lanes(dword0);
+            auto lanes = ~okmask & fast & 0xff;
+            // other header lengths take the scalar path
+            for (auto slow = ~fast & 0xff; slow; slow &= slow - 1) {
+                auto k = __builtin_ctz(slow);
+                if (!fastcsum_ipv4_hdr_verify(hdrs[i + j + k]))
+                    lanes |= 1u << k;
+            }
+            word |= static_cast<uint64_t>(lanes) << j;
+        }
+        for (; j < 64 && i + j < n; j++)
+            word |= static_cast<uint64_t>(!fastcsum_ipv4_hdr_verify(hdrs[i + j])) << j;
+        invalid[i / 64] = word;
+        bad += __builtin_popcountll(word);
+    }
+    return bad;
+}
+
+extern "C" void fastcsum_ipv4_hdr_generate_batch_avx2(uint8_t *const hdrs[], size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i dword0;
+        auto s = sum_headers(const_cast<const uint8_t *const *>(&hdrs[i]), true, dword0);
+        uint32_t sums[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i_u *>(sums), s);
+        auto fast = ihl5_lanes(dword0);
+        for (size_t k = 0; k < 8; k++) {
+            if (fast & (1u << k))
+                *reinterpret_cast<u16u *>(&hdrs[i + k][10]) = static_cast<uint16_t>(~sums[k]);
+            else
+                fastcsum_ipv4_hdr_generate(hdrs[i + k]);
+        }
+    }
+    for (; i < n; i++)
+        fastcsum_ipv4_hdr_generate(hdrs[i]);
+}
+
+#endif